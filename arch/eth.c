@@ -45,6 +45,7 @@
 #include <stdio.h>
 
 // @@@
+#include <kstat.h>
 #include "../net/dll/eth.h"
 
 #define MIICmd_Write	(1<<14)
@@ -103,12 +104,14 @@ struct tx_sts {
 #define TX_DESC_NUM	RX_DESC_NUM
 #define TX_STS_NUM	TX_DESC_NUM
 
-struct rx_desc rx_desc[RX_DESC_NUM];
-struct rx_sts  rx_sts[RX_STS_NUM];
+// The MAC reads and writes these behind the CPU's back, so they all live
+// in the uncached DMA region
+struct rx_desc rx_desc[RX_DESC_NUM] __dma;
+struct rx_sts  rx_sts[RX_STS_NUM] __dma;
 char *rx_buf = NULL;
 
-struct tx_desc tx_desc[TX_DESC_NUM];
-struct tx_sts  tx_sts[TX_STS_NUM];
+struct tx_desc tx_desc[TX_DESC_NUM] __dma;
+struct tx_sts  tx_sts[TX_STS_NUM] __dma;
 char *tx_buf = NULL;
 
 static struct en_eth_if eth_if;
@@ -304,32 +307,40 @@ static void process_rx_queue(struct en_eth_if *dev)
 	int q = 0;
 
 	struct en_net_pkt *pkt;
+	char *buf;
+	int hlen;
 
 	cur = (struct rx_sts *)inl(RXStsQCurAdd);
 
 	do {
 		++q;
 
+		kstat_write_begin();
 		dev->stats.rx_frames++;
 		dev->stats.rx_bytes += last->FrameLength;
-
-		// @@@ why is there zero frames at first?
-		if (last->FrameLength < 60) {
+		if (last->FrameLength < 60)
 			dev->stats.runts++;
-			continue;
-		} else if (last->FrameLength > 1518) {
+		else if (last->FrameLength > 1518)
 			dev->stats.oversized++;
+		kstat_write_end();
+
+		// @@@ why is there zero frames at first?
+		if (last->FrameLength < 60 || last->FrameLength > 1518)
 			continue;
-		}
 
 		pkt = pkt_alloc(last->FrameLength);
 		if (pkt == NULL) {
 			printf("pkt_alloc failed\r\n");
 		} else {
 			// @@@ use pkt_add
-			memcpy(	pkt->data,
-				(char *)rx_desc[last->BufferIndex].RxBufAdr,
-				last->FrameLength);
+			// Sum the payload on the way past, for the transport
+			// layer's checksum
+			buf = (char *)rx_desc[last->BufferIndex].RxBufAdr;
+			hlen = sizeof(struct en_eth_mac_hdr);
+			memcpy(pkt->data, buf, hlen);
+			pkt->csum = cksum_copy(pkt->data + hlen, buf + hlen,
+				last->FrameLength - hlen, 0);
+			pkt->csum_valid = 1;
 
 			pkt->len = last->FrameLength;
 			en_eth_rx(dev, pkt);
@@ -399,13 +410,13 @@ void ep9301_eth_init(void)
 	struct en_ip_route *rt;
 
 	// Obtain necessary memory
-	rx_buf = smalloc(RX_DESC_NUM * RX_BUF_SIZE);
+	rx_buf = dma_alloc(RX_DESC_NUM * RX_BUF_SIZE, 0);
 	if (rx_buf == NULL) {
 		printf("Failed to allocate memory for Ethernet receive buffers\r\n");
 		return;
 	}
 
-	tx_buf = smalloc(TX_DESC_NUM * TX_BUF_SIZE);
+	tx_buf = dma_alloc(TX_DESC_NUM * TX_BUF_SIZE, 0);
 	if (tx_buf == NULL) {
 		printf("Failed to allocate memory for Ethernet transmit buffers\r\n");
 		return;
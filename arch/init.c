@@ -39,10 +39,12 @@
 #include <sys/uart.h>
 #include <sys/irq.h>
 #include <sys/timers.h>
+#include <sys/cons.h>
 
 #include <types.h>
 #include <string.h>
 #include <nand.h>
+#include <kstat.h>
 
 #include "regs.h"
 
@@ -66,11 +68,11 @@ void arm_irq_entry(void);
 void arm_svc_entry(void);
 
 // @@@ declare elsewhere
-void cons_init(struct uart *uart);
 extern struct uart_ops ep93xx_uart_ops;
 
 // @@@ static?
-struct uart uart1;
+struct uart uart1;		// Console
+struct uart uart2;		// Data channel, kept off the console
 
 void _putchar(char c)
 {
@@ -145,6 +147,15 @@ int _printf_x(uint32_t x)
 
 #define HEARTBEAT_MS 100
 
+#define TIMER3_LOAD	5080	// 100Hz from the 508kHz clock
+
+// Time since Timer3 fired, in us.  It reloads and keeps counting down from
+// TIMER3_LOAD at 508kHz, roughly 2us per count.
+static uint32_t timer3_latency(void)
+{
+	return (TIMER3_LOAD - inl(Timer3Value)) * 2;
+}
+
 // Processor-specific timer interrupt
 void _timer_int(void)
 {
@@ -234,10 +245,14 @@ static void init_interrupts(void)
 	// @@@ this should be Timer1 or Timer2, since they are only 16 bit
 	// and 16 bit is more than we need
 	register_irq_handler(TC3OI, _timer_int, 0);
+	irq_set_latency_probe(TC3OI, timer3_latency);
 	enable_irq(TC3OI);
 
-	outl(Timer3Load, 5080);		// 100Hz
+	outl(Timer3Load, TIMER3_LOAD);	// 100Hz
 	outl(Timer3Control, 0xc8);	// enable timer
+
+	// The free running debug timer, used for timestamps, was started
+	// by main() so that boot can be timed
 }
 
 static void init_traps(void)
@@ -284,6 +299,18 @@ void arch_init(void)
 	// Initialize UART1/console
 	memset(&uart1, 0, sizeof(struct uart));
 	uart1.uart_ops = &ep93xx_uart_ops;
+	uart1.unit = 0;
+	uart1.stat = &kstat.uart[0];
+	uart1.fifo_stat = &kstat.uart_fifo[0];
 	uart1.uart_ops->open(&uart1);
 	cons_init(&uart1);
+
+	// Initialize UART2, for bulk data.  The EP9301/2 have no UART3.
+	memset(&uart2, 0, sizeof(struct uart));
+	uart2.uart_ops = &ep93xx_uart_ops;
+	uart2.unit = 1;
+	uart2.stat = &kstat.uart[1];
+	uart2.fifo_stat = &kstat.uart_fifo[1];
+	if (uart2.uart_ops->open(&uart2))
+		_puts("uart2: open failed\r\n");
 }
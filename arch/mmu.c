@@ -33,8 +33,11 @@
  * EP93xx memory management.
  */
 
+#include <sys/cache.h>
+
 #include <types.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "mmu.h"
 
@@ -69,7 +72,7 @@ static const char *fsr_faults[] = {
 };
 
 // Pointer to MMU translation table
-static uint32_t *ttb = (uint32_t *)TTB;
+static uint32_t *ttb = __ttb__;
 
 // @@@ kernel/mem.c
 void user_page_fault(void *ptr);
@@ -114,18 +117,14 @@ void _system_page_fault(void)
 	user_page_fault(far);
 }
 
-#define mmu_invalidate_caches() \
-	asm(	"mov	r1, #0			\r\n"	\
-		"mcr	p15, 0, r1, c7, c7, 0	\r\n"	\
-		::: "r1"				\
-	)
-
 #define mmu_invalidate_tlb() \
 	asm(	"mov	r1, #0			\r\n"	\
 		"mcr	p15, 0, r1, c8, c7, 0	\r\n"	\
 		::: "r1"				\
 	)
 
+// Map a 1MB section.  flags holds the access permissions and any of the
+// MMU_C/MMU_B cache attributes; without them the section is uncached.
 void _mmu_remap(void *virt, void *phys, int flags)
 {
 	uint32_t entry = 0;
@@ -138,8 +137,107 @@ void _mmu_remap(void *virt, void *phys, int flags)
 	entry = (uint32_t)phys & MMU_SECTION_MASK;
 	entry |= flags & (~MMU_SECTION_MASK);
 
+	// The D-cache is write-back, so anything dirty under the old mapping
+	// has to reach memory before the attributes change
+	dcache_flush_all();
+	icache_inval();
+
 	ttb[idx] = entry;
 
-	mmu_invalidate_caches();
 	mmu_invalidate_tlb();
 }
+
+// Map the section holding the translation tables through the coarse table
+// at table, so that its first len bytes, the tables themselves, can be
+// made supervisor only.  The rest of the section keeps its permissions.
+void _mmu_protect_tables(uint32_t *table, size_t len)
+{
+	uint32_t sec = (uint32_t)ttb & MMU_SECTION_MASK;
+	int idx = sec >> MMU_SECTION_SHIFT;
+	uint32_t old = ttb[idx];
+	uint32_t a, ap;
+	int i;
+
+	for (i = 0; i < MMU_COARSE_SIZE / 4; ++i) {
+		a = sec + (i << MMU_PAGE_SHIFT);
+		ap = a - sec < len ? MMU_AP_SRW_UNA >> 10 : (old >> 10) & 3;
+		table[i] = a | (ap << 4) | (ap << 6) | (ap << 8) | (ap << 10)
+			| (old & (MMU_C | MMU_B)) | MMU_SMALL_PAGE;
+	}
+
+	ttb[idx] = ((uint32_t)table & MMU_COARSE_MASK) | TT_BIT
+		| (old & DOMAIN) | MMU_COARSE;
+
+	drain_write_buffer();
+	mmu_invalidate_tlb();
+}
+
+// Replace the 1MB section at virt with the coarse page table at table,
+// which must be MMU_COARSE_SIZE aligned and uncached.  Every page starts
+// out unmapped.  Accesses are checked against domain.
+void _mmu_coarse(void *virt, uint32_t *table, int domain)
+{
+	int idx = ((uint32_t)virt & MMU_SECTION_MASK) >> MMU_SECTION_SHIFT;
+
+	memset(table, 0, MMU_COARSE_SIZE);
+
+	dcache_flush_all();
+	icache_inval();
+
+	ttb[idx] = ((uint32_t)table & MMU_COARSE_MASK) | TT_BIT
+		| (domain << MMU_DOMAIN_SHIFT) | MMU_COARSE;
+
+	mmu_invalidate_tlb();
+}
+
+// Identity map the 4k pages covering [virt, virt + len), which must lie
+// in sections set up by _mmu_coarse().  flags holds a section AP value,
+// used for all four subpages, and the cache attributes.  Privileged only.
+//
+// Unmapped entries are never held in the TLB, so no TLB maintenance is
+// needed.
+void _mmu_map_pages(void *virt, size_t len, int flags)
+{
+	uint32_t a = (uint32_t)virt & ~(MMU_PAGE_SIZE - 1);
+	uint32_t end = (uint32_t)virt + len;
+	uint32_t ap = (flags >> 10) & 3;
+	uint32_t *table;
+
+	ap = (ap << 4) | (ap << 6) | (ap << 8) | (ap << 10);
+
+	for (; a < end; a += MMU_PAGE_SIZE) {
+		table = (uint32_t *)(ttb[a >> MMU_SECTION_SHIFT] & MMU_COARSE_MASK);
+		table[(a >> MMU_PAGE_SHIFT) & 0xFF] = a | ap
+			| (flags & (MMU_C | MMU_B)) | MMU_SMALL_PAGE;
+	}
+}
+
+// Unmap the 4k pages covering [virt, virt + len).  Privileged only.
+void _mmu_unmap_pages(void *virt, size_t len)
+{
+	uint32_t a = (uint32_t)virt & ~(MMU_PAGE_SIZE - 1);
+	uint32_t end = (uint32_t)virt + len;
+	uint32_t *table;
+
+	for (; a < end; a += MMU_PAGE_SIZE) {
+		table = (uint32_t *)(ttb[a >> MMU_SECTION_SHIFT] & MMU_COARSE_MASK);
+		table[(a >> MMU_PAGE_SHIFT) & 0xFF] = 0;
+
+		// Identity mapped, so cached lines for the page stay valid and
+		// only the translation has to go.  The ARM920T has split TLBs
+		// with no combined single entry operation.
+		asm volatile(
+			"mcr	p15, 0, %0, c8, c6, 1	\r\n"	// D TLB entry
+			"mcr	p15, 0, %0, c8, c5, 1	\r\n"	// I TLB entry
+			: : "r" (a) : "memory");
+	}
+
+	drain_write_buffer();
+}
+
+// Load the domain access control register.  Switching tasks only changes
+// which domains are accessible, leaving the TLB and caches intact.
+void _mmu_set_domains(uint32_t dacr)
+{
+	asm("mcr	p15, 0, %0, c3, c0, 0" : : "r" (dacr));
+}
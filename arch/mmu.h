@@ -36,19 +36,55 @@
 #ifndef _ARCH_MMU_H
 #define _ARCH_MMU_H
 
-// Translation table base
-#define TTB		0x00300000
+#include <types.h>
+
+// Translation table, at the start of the uncached DMA region so the table
+// walk always sees what was written.  See the linker script.
+extern uint32_t __ttb__[];
+
+// Coarse tables, up to __dma_data__.  Supervisor only, like the TTB.
+extern uint32_t __pgt__[];
+extern char __dma_data__[];
 
 #define MMU_SECTION		0x02	// 1MB page
 #define MMU_SECTION_MASK	0xFFF00000
+#define MMU_SECTION_SHIFT	20
+
+// Second level, coarse tables of 256 small (4k) pages
+#define MMU_COARSE		0x01	// First level descriptor type
+#define MMU_COARSE_SIZE		1024	// Bytes per table, also its alignment
+#define MMU_COARSE_MASK		0xFFFFFC00
+#define MMU_SMALL_PAGE		0x02	// Second level descriptor type
+#define MMU_PAGE_SHIFT		12
+#define MMU_PAGE_SIZE		(1 << MMU_PAGE_SHIFT)
+
+// Section cache attributes
+#define MMU_B			0x04	// Bufferable
+#define MMU_C			0x08	// Cacheable
+#define MMU_UNCACHED		0		// Devices and DMA memory
+#define MMU_WRITETHROUGH	MMU_C
+#define MMU_WRITEBACK		(MMU_C | MMU_B)	// Normal RAM
 
 #define TT_BIT		0x10	// Legacy, should always be set
 #define DOMAIN		0x1e0	// Domain 15
 
+// Domains.  Everything shared lives in domain 15; the rest are handed out
+// to tasks, see kernel/vm.c.
+#define MMU_DOMAINS		16
+#define MMU_DOMAIN_KERNEL	15
+#define MMU_DOMAIN_SHIFT	5
+#define DACR_CLIENT		1	// Accesses are checked against AP
+#define dacr_client(d)		(DACR_CLIENT << ((d) * 2))
+
 // MMU Access Permissions
 #define MMU_AP_SRW_UNA	0x400	// System R/W, User No Access
 #define MMU_AP_SRW_URW	0xc00	// System R/W, User R/W
 
 void _mmu_remap(void *virt, void *phys, int flags);
+void _mmu_protect_tables(uint32_t *table, size_t len);
+void _mmu_coarse(void *virt, uint32_t *table, int domain);
+void _mmu_map_pages(void *virt, size_t len, int flags);
+void _mmu_unmap_pages(void *virt, size_t len);
+void _mmu_set_domains(uint32_t dacr);
 
 #endif // !_ARCH_MMU_H
@@ -82,6 +82,9 @@
 #define	Timer3Value		(TIMER_BASE + 0x0084)
 #define	Timer3Control		(TIMER_BASE + 0x0088)
 #define	Timer3Clear		(TIMER_BASE + 0x008C)
+#define	Timer4ValueLow		(TIMER_BASE + 0x0060)	// 40-bit debug timer
+#define	Timer4ValueHigh		(TIMER_BASE + 0x0064)
+#define	Timer4Enable		(1<<8)
 
 #define GPIO_BASE		(REG_BASE + 0x00840000)
 #define	PEDR			(GPIO_BASE + 0x0020)
@@ -117,38 +120,62 @@
 #define SSPIIR			(SPI_BASE + 0x0014)	// Interrupt ID register
 #define SSPICR			(SPI_BASE + 0x0014)	// Interrupt clear reg.
 
-#define UART_BASE		(REG_BASE + 0x008C0000)
-#define UART1Data		(UART_BASE)
-#define UART1LinCtrlHigh	(UART_BASE + 0x0008)
-#define UART1LinCtrlMed		(UART_BASE + 0x000C)
-#define UART1LinCtrlLow		(UART_BASE + 0x0010)
-#define UART1Ctrl		(UART_BASE + 0x0014)
-#define UART1Flag		(UART_BASE + 0x0018)
-#define UART1IntIDIntClr	(UART_BASE + 0x001C)
-
-// UART1LinCtrlHigh bits
+#define UART1_BASE		(REG_BASE + 0x008C0000)
+#define UART2_BASE		(REG_BASE + 0x008D0000)
+#define UART3_BASE		(REG_BASE + 0x008E0000)	// EP9307 and up
+
+// UART register offsets, from any of the UARTn_BASE
+#define UARTData		0x0000
+#define UARTRXSts		0x0004
+#define UARTLinCtrlHigh		0x0008
+#define UARTLinCtrlMed		0x000C
+#define UARTLinCtrlLow		0x0010
+#define UARTCtrl		0x0014
+#define UARTFlag		0x0018
+#define UARTIntIDIntClr		0x001C
+
+#define UART1Data		(UART1_BASE + UARTData)
+#define UART1RXSts		(UART1_BASE + UARTRXSts)
+#define UART1LinCtrlHigh	(UART1_BASE + UARTLinCtrlHigh)
+#define UART1LinCtrlMed		(UART1_BASE + UARTLinCtrlMed)
+#define UART1LinCtrlLow		(UART1_BASE + UARTLinCtrlLow)
+#define UART1Ctrl		(UART1_BASE + UARTCtrl)
+#define UART1Flag		(UART1_BASE + UARTFlag)
+#define UART1IntIDIntClr	(UART1_BASE + UARTIntIDIntClr)
+
+#define UART_CLK	7372800	// UARTCLK, 14.7456MHz / 2
+
+// UARTRXSts bits, cleared by writing to the register
+#define OE	0x08	// Overrun, RX FIFO was full
+
+// UARTLinCtrlHigh bits
 #define FEN	0x10	// FIFO enable
 #define WLEN_8	0x60	// 8 bits per frame
 
-// UART1Ctrl bits
+// UARTCtrl bits
 #define UARTE	0x01	// UART enable
 #define RIE	0x10	// RX interrupt enable
 #define TIE	0x20	// TX interrupt enable
+#define RTIE	0x40	// RX timeout interrupt enable
 
-// UART1Flag bits
+// UARTFlag bits
+#define BUSY	0x08	// Transmitting
 #define RXFE	0x10	// RX FIFO empty
 #define TXFF	0x20	// TX FIFO full
 #define RXFF	0x40	// RX FIFO full
 #define TXFE	0x80	// TX FIFO empty
 
-// UART1IntIDIntClr bits
+// UARTIntIDIntClr bits
 #define RIS	0x02	// RX interrupt status
 #define TIS	0x04	// TX interrupt status
+#define RTIS	0x08	// RX timeout interrupt status
 
 #define TINTR		35	// 64Hz timer interrupt
 #define INT_MAC		39	// Ethernet MAC Interrupt
 #define TC3OI		51	// Timer3 interrupt
 #define INT_UART1	52	// UART1 interrupt
+#define INT_UART2	54	// UART2 interrupt
+#define INT_UART3	55	// UART3 interrupt
 #define USHINTR		56	// USB Host Interrupt
 
 // Ethernet Controller Registers
@@ -300,6 +327,12 @@
 
 #define	PwrCnt		(INTERNAL_BASE + 0x0004)// Clock/debug control status
 #define PwrCnt_USH_EN	(1<<28)			// USB host clock
+#define	DeviceCfg	(INTERNAL_BASE + 0x0080)// Peripheral enables
+#define DeviceCfg_U1EN	(1<<18)			// UART1 enable
+#define DeviceCfg_U2EN	(1<<20)			// UART2 enable
+#define DeviceCfg_U3EN	(1<<24)			// UART3 enable
+#define	SysSWLock	(INTERNAL_BASE + 0x00C0)// Unlocks DeviceCfg
+#define SysSWLock_KEY	0xAA			// for one write
 
 
 // Memory accessors
@@ -38,72 +38,148 @@
 #include <sys/list.h>
 
 #include <string.h>
+#include <kstat.h>
 
 #include "regs.h"
 
 static void ep93xx_uart_enable_rx(struct uart *uart);
+static int ep93xx_uart_set_baud(struct uart *uart, int baud);
+
+#define uart_in(uart, reg)	inl((uart)->base + (reg))
+#define uart_out(uart, reg, val)	outl((uart)->base + (reg), val)
+
+static void uart1_intr(void);
+static void uart2_intr(void);
+static void uart3_intr(void);
+
+// The ports, by unit number
+static struct {
+	uint32_t base;
+	int irq;
+	uint32_t enable;		// DeviceCfg bit
+	void (*intr)(void);
+} ep93xx_uart_ports[] = {
+	{ UART1_BASE, INT_UART1, DeviceCfg_U1EN, uart1_intr },
+	{ UART2_BASE, INT_UART2, DeviceCfg_U2EN, uart2_intr },
+	{ UART3_BASE, INT_UART3, DeviceCfg_U3EN, uart3_intr },
+};
+
+#define EP93XX_UARTS	(sizeof(ep93xx_uart_ports) / sizeof(ep93xx_uart_ports[0]))
+
+// Open devices, by unit number, for the interrupt handlers
+static struct uart *ep93xx_uarts[EP93XX_UARTS];
+
+static void ep93xx_uart_intr(struct uart *uart)
+{
+	uint32_t reg = uart_in(uart, UARTIntIDIntClr);
+
+	++uart->stat->interrupts;
 
-extern struct uart uart1; // @@@
+	// RX FIFO half full, or holding data that has sat there for a while?
+	if (reg & (RIS | RTIS)) {
+		++uart->fifo_stat->rx_interrupts;
+		uart->uart_ops->rx(uart);
+	}
+
+	// TX FIFO half empty?
+	if (reg & TIS) {
+		++uart->fifo_stat->tx_interrupts;
+		uart->uart_ops->tx(uart);
+	}
+}
 
+// Handlers don't get an argument, so each port needs its own
 static void uart1_intr(void)
 {
-	uint32_t reg = inl(UART1IntIDIntClr);
+	ep93xx_uart_intr(ep93xx_uarts[0]);
+}
 
-	// RX interrupt?
-	if (reg & RIS)
-		uart1.uart_ops->rx(&uart1);
+static void uart2_intr(void)
+{
+	ep93xx_uart_intr(ep93xx_uarts[1]);
+}
 
-	// TX interrupt?
-	if (reg & TIS)
-		uart1.uart_ops->tx(&uart1);
+static void uart3_intr(void)
+{
+	ep93xx_uart_intr(ep93xx_uarts[2]);
 }
 
 // Returns zero on success, -1 on failure
 static int ep93xx_uart_open(struct uart *uart)
 {
-	uint32_t br;
+	int unit = uart->unit;
+
+	// A port already open through this same struct stays open
+	if (unit >= 0 && unit < EP93XX_UARTS && ep93xx_uarts[unit] == uart)
+		return -1;
+
+	uart->state = UART_CLOSED;
+	uart->wait.wait = NULL;
+	uart->tx_wait.wait = NULL;
+
+	if (unit < 0 || unit >= EP93XX_UARTS || ep93xx_uarts[unit] != NULL)
+		return -1;
+
+	uart->base = ep93xx_uart_ports[unit].base;
+	uart->irq = ep93xx_uart_ports[unit].irq;
 
 	// Allocate a wait queue for this device
 	// @@@ need a generic completion creation function
 	uart->wait.wait = bfifo_alloc(10);
-	if (uart->wait.wait == NULL)
-		return -1;
+	uart->tx_wait.wait = bfifo_alloc(10);
+	if (uart->wait.wait == NULL || uart->tx_wait.wait == NULL)
+		goto out_err;
 
 	// Clear FIFOs
 	memset(&uart->rx_fifo, 0, sizeof(struct uart_fifo));
 	memset(&uart->tx_fifo, 0, sizeof(struct uart_fifo));
 
-	uart->baud = 115200;	// Default to 115200
-
-	// BAUD rate divisor = FUARTCLK / (16 * desired_rate)
-	br = 3; // 7372800 / (16 * uart->baud) - 1;
-	outl(UART1LinCtrlLow, br & 0xff);
-	outl(UART1LinCtrlMed, (br & 0xff00) >> 8);
+	// Make sure the port is clocked; the boot loader only sets up
+	// the console
+	if (!(inl(DeviceCfg) & ep93xx_uart_ports[unit].enable)) {
+		outl(SysSWLock, SysSWLock_KEY);
+		outl(DeviceCfg, inl(DeviceCfg) | ep93xx_uart_ports[unit].enable);
+	}
 
-	// Enable FIFOs, 8N1
-	//*UART1LinCtrlHigh = FEN | WLEN_8;// High must be last to cause Med
-					// Low to be registered
-	// 8N1
-	outl(UART1LinCtrlHigh, WLEN_8);
+	// Default to 115200, 8N1 with the 16 byte FIFOs enabled
+	ep93xx_uart_set_baud(uart, 115200);
 
 	// Set up a single interrupt
-	register_irq_handler(INT_UART1, uart1_intr, 0);
+	ep93xx_uarts[unit] = uart;
+	if (register_irq_handler(uart->irq, ep93xx_uart_ports[unit].intr, 0)) {
+		ep93xx_uarts[unit] = NULL;
+		goto out_err;
+	}
 
-	// Enable the UART, with TX and RX interrupts
-	outl(UART1Ctrl, RIE | TIE | UARTE);
-	enable_irq(INT_UART1);
+	// Enable the UART, with TX and RX interrupts.  The RX interrupt comes
+	// with the FIFO half full, or from the timeout once data has waited
+	// 32 bit periods, so input arrives in batches either way.
+	uart_out(uart, UARTCtrl, RIE | RTIE | TIE | UARTE);
+	enable_irq(uart->irq);
 
 	//ep93xx_uart_enable_rx(uart);
 
 	uart->state = UART_OPEN;
 
 	return 0;
+
+out_err:
+	if (uart->wait.wait != NULL)
+		bfifo_free(uart->wait.wait);
+	if (uart->tx_wait.wait != NULL)
+		bfifo_free(uart->tx_wait.wait);
+	uart->wait.wait = NULL;
+	uart->tx_wait.wait = NULL;
+
+	return -1;
 }
 
 static void ep93xx_uart_close(struct uart *uart)
 {
 	// Disable the UART
-	outl(UART1Ctrl, (inl(UART1Ctrl) &= ~UARTE));
+	disable_irq(uart->irq);
+	uart_out(uart, UARTCtrl, uart_in(uart, UARTCtrl) & ~UARTE);
+	ep93xx_uarts[uart->unit] = NULL;
 	
 	// Clear FIFOs
 	memset(&uart->rx_fifo, 0, sizeof(struct uart_fifo));
@@ -115,34 +191,69 @@ static void ep93xx_uart_close(struct uart *uart)
 // Return 0 on success, -1 on failure
 static int ep93xx_uart_set_baud(struct uart *uart, int baud)
 {
-	// @@@ Actually set the BAUD!
+	uint32_t div, actual, err;
+
+	if (baud <= 0 || baud > UART_CLK / 16)
+		return -1;
+
+	// BAUD rate divisor = UART_CLK / (16 * baud) - 1, rounded to the
+	// nearest.  115200 gives 3, 230400 gives 1 and 460800 gives 0.
+	div = (UART_CLK / 16 + baud / 2) / baud;
+	actual = UART_CLK / 16 / div;
+	err = actual > baud ? actual - baud : baud - actual;
+
+	// More than about 3% out and the far end won't follow
+	if (err > baud / 32 || div - 1 > 0xffff)
+		return -1;
+	--div;
+
+	// Let the interrupt handler empty the software ring at the old rate
+	// first; only then is the 16 byte hardware FIFO all that is left
+	uart->uart_ops->enable_tx(uart);
+	while (uart_fifo_available(&uart->tx_fifo) != 0)
+		uart_fifo_barrier();
+
+	// Let the transmitter finish what it has at the old rate
+	uart->uart_ops->disable_tx(uart);
+	while ((uart_in(uart, UARTFlag) & (TXFE | BUSY)) != TXFE)
+		;
+
+	uart_out(uart, UARTLinCtrlLow, div & 0xff);
+	uart_out(uart, UARTLinCtrlMed, (div >> 8) & 0xff);
+
+	// High must be last to cause Med and Low to be registered
+	uart_out(uart, UARTLinCtrlHigh, FEN | WLEN_8);
+
 	uart->baud = baud;
 
+	// The handler turns this straight back off if there is nothing to send
+	uart->uart_ops->enable_tx(uart);
+
 	return 0;
 }
 
 static void ep93xx_uart_disable_tx(struct uart *uart)
 {
 	// Disable the TX interrupt
-	outl(UART1Ctrl, (inl(UART1Ctrl) &= ~TIE));
+	uart_out(uart, UARTCtrl, uart_in(uart, UARTCtrl) & ~TIE);
 }
 
 static void ep93xx_uart_enable_tx(struct uart *uart)
 {
 	// Enable the TX interrupt
-	outl(UART1Ctrl, (inl(UART1Ctrl) |= TIE));
+	uart_out(uart, UARTCtrl, uart_in(uart, UARTCtrl) | TIE);
 }
 
 static void ep93xx_uart_disable_rx(struct uart *uart)
 {
 	// Disable the RX interrupt
-	outl(UART1Ctrl, (inl(UART1Ctrl) &= ~RIE));
+	uart_out(uart, UARTCtrl, uart_in(uart, UARTCtrl) & ~RIE);
 }
 
 static void ep93xx_uart_enable_rx(struct uart *uart)
 {
 	// Enable the RX interrupt
-	outl(UART1Ctrl, (inl(UART1Ctrl) |= RIE));
+	uart_out(uart, UARTCtrl, uart_in(uart, UARTCtrl) | RIE);
 }
 
 // kernel/syscall.c @@@
@@ -152,15 +263,38 @@ static void ep93xx_uart_rx(struct uart *uart)
 {
 	struct uart_fifo *f = &uart->rx_fifo;
 	struct completion *c = &uart->wait;
+	uint32_t tail = f->tail;
 	int free = uart_fifo_free(f);
+	int n = 0;
 
-	while (!(inl(UART1Flag) & RXFE) && free > 0) {
-		f->data[f->tail] = inl(UART1Data);
-		if (++f->tail >= sizeof(f->data))
-			f->tail = 0;
+	while (!(uart_in(uart, UARTFlag) & RXFE) && free > 0) {
+		f->data[tail++ & UART_FIFO_MASK] = uart_in(uart, UARTData);
 		--free;
+		++n;
 	}
 
+	// Publish everything received at once
+	uart_fifo_barrier();
+	f->tail = tail;
+
+	kstat_write_begin();
+
+	uart->stat->rx_bytes += n;
+
+	// Drain anything left over so the interrupt deasserts
+	while (!(uart_in(uart, UARTFlag) & RXFE)) {
+		uart_in(uart, UARTData);
+		++uart->stat->rx_dropped;
+	}
+
+	// Data lost before we got to the FIFO
+	if (uart_in(uart, UARTRXSts) & OE) {
+		++uart->fifo_stat->rx_overruns;
+		uart_out(uart, UARTRXSts, 0);
+	}
+
+	kstat_write_end();
+
 	// Notify anyone waiting @@@ must break system call up
 	sys_wake((uint32_t *)&c);
 }
@@ -168,19 +302,32 @@ static void ep93xx_uart_rx(struct uart *uart)
 static void ep93xx_uart_tx(struct uart *uart)
 {
 	struct uart_fifo *f = &uart->tx_fifo;
+	struct completion *c = &uart->tx_wait;
+	uint32_t head = f->head;
+	uint32_t tail = f->tail;
 
 	// Disable transmit if we have no data
-	if (f->head == f->tail) {
+	if (head == tail) {
 		uart->uart_ops->disable_tx(uart);
-		return;
+	} else {
+		uart_fifo_barrier();
+
+		// TX interrupt called us, so fill up the queue as much as
+		// possible
+		while (!(uart_in(uart, UARTFlag) & TXFF) && head != tail) {
+			uart_out(uart, UARTData, f->data[head++ & UART_FIFO_MASK]);
+			++uart->stat->tx_bytes;
+		}
+
+		// Hand the space back to writers
+		uart_fifo_barrier();
+		f->head = head;
 	}
 
-	// TX interrupt called us, so fill up the queue as much as possible
-	while (!(inl(UART1Flag) & TXFF) && f->head != f->tail) {
-		outl(UART1Data, f->data[f->head]);
-		if (++f->head >= sizeof(f->data))
-			f->head = 0;
-	}
+	// Wake blocked writers once there is room for a good chunk, rather
+	// than for every few bytes sent
+	if (!bfifo_empty(c->wait) && uart_fifo_free(f) >= UART_FIFO_SIZE / 2)
+		sys_wake((uint32_t *)&c);
 }
 
 struct uart_ops ep93xx_uart_ops = {
@@ -55,6 +55,8 @@
  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <string.h>
+
 #include "hamming.h"
 
 /* Classic binary divide-and-conquer popcount.
@@ -74,144 +76,150 @@ popcount32(uint32_t x)
     return (x + (x >> 16)) & 0x3f;
 }
 
-/**
- * Calculates the 22-bit hamming code for a 256-bytes block of data.
- * \param data  Data buffer to calculate code for.
- * \param code  Pointer to a buffer where the code should be stored.
+/*-
+ * Parity groups are formed by forcing a particular index bit to 0 (even)
+ * or 1 (odd).  Example on one byte:
+ *
+ * bits (dec)  7   6   5   4   3   2   1   0
+ *      (bin) 111 110 101 100 011 010 001 000
+ *
+ * groups P4' ooooooooooooooo eeeeeeeeeeeeeee P4
+ *        P2' ooooooo eeeeeee ooooooo eeeeeee P2
+ *        P1' ooo eee ooo eee ooo eee ooo eee P1
+ *
+ * The same goes for the bytes of a block, by byte offset.  The odd line
+ * code is then the xor of the offsets of all bytes with odd parity, and
+ * the even line code the xor of 255 minus those offsets, which is the odd
+ * code inverted if there is an odd number of such bytes.  As that number
+ * is odd exactly when the block as a whole has odd parity, only the odd
+ * code has to be gathered.  Columns work the same way on the xor of all
+ * bytes.
+ *
+ * hamming_sums() in hamming_arm.s gathers the column sum and odd line
+ * code a word at a time; the tables below turn those into the code.
  */
-void
-hamming_compute_256(const uint8_t *data, uint8_t *code)
-{
-	unsigned int i;
-	uint8_t column_sum = 0;
-	uint8_t even_line_code = 0;
-	uint8_t odd_line_code = 0;
-	uint8_t even_column_code = 0;
-	uint8_t odd_column_code = 0;
-
-	/*-
-	 * Xor all bytes together to get the column sum;
-	 * At the same time, calculate the even and odd line codes
-	 */
-	for (i = 0; i < 256; i++) {
-		column_sum ^= data[i];
 
-		/*-
-		 * If the xor sum of the byte is 0, then this byte has no
-		 * incidence on the computed code; so check if the sum is 1.
-		 */
-		//if ((popcount(data[i]) & 1) == 1) {
-		if ((popcount32(data[i]) & 1) == 1) {
-			/*-
-			 * Parity groups are formed by forcing a particular
-			 * index bit to 0 (even) or 1 (odd).
-			 * Example on one byte:
-			 * 
-			 * bits (dec)  7   6   5   4   3   2   1   0    
-			 *      (bin) 111 110 101 100 011 010 001 000    
-			 *                            '---'---'---'----------.
-			 *                                                   |
-			 * groups P4' ooooooooooooooo eeeeeeeeeeeeeee P4     |
-			 *        P2' ooooooo eeeeeee ooooooo eeeeeee P2     |
-			 *        P1' ooo eee ooo eee ooo eee ooo eee P1     |
-			 *                                                   |
-			 * We can see that:                                  |
-			 *  - P4  -> bit 2 of index is 0 --------------------'
-			 *  - P4' -> bit 2 of index is 1.
-			 *  - P2  -> bit 1 of index if 0.
-			 *  - etc...
-			 * We deduce that a bit position has an impact on all
-			 * even Px if the log2(x)nth bit of its index is 0
-			 *     ex: log2(4) = 2,
-			 * bit2 of the index must be 0 (-> 0 1 2 3)
-			 * and on all odd Px' if the log2(x)nth bit
-			 * of its index is 1
-			 *     ex: log2(2) = 1,
-			 * bit1 of the index must be 1 (-> 0 1 4 5)
-			 * 
-			 * As such, we calculate all the possible Px and Px'
-			 * values at the same time in two variables,
-			 * even_line_code and odd_line_code, such as
-			 *     even_line_code bits: P128  P64  P32
-			 *                        P16  P8  P4  P2  P1
-			 *     odd_line_code  bits: P128' P64' P32' P16'
-			 *                        P8' P4' P2' P1'
-			 */
-			even_line_code ^= (255 - i);
-			odd_line_code ^= i;
-		}
-	}
-
-	/*- 
-	 * At this point, we have the line parities, and the column sum.
-	 * First, We must caculate the parity group values on the column sum.
-	 */
-	for (i = 0; i < 8; i++) {
-		if (column_sum & 1) {
-			even_column_code ^= (7 - i);
-			odd_column_code ^= i;
-		}
-		column_sum >>= 1;
-	}
-
-	/*-
-	 * Now, we must interleave the parity values,
-	 * to obtain the following layout:
-	 * Code[0] = Line1
-	 * Code[1] = Line2
-	 * Code[2] = Column
-	 * Line = Px' Px P(x-1)- P(x-1) ...
-	 * Column = P4' P4 P2' P2 P1' P1 PadBit PadBit 
-	 */
-	code[0] = 0;
-	code[1] = 0;
-	code[2] = 0;
-
-	for (i = 0; i < 4; i++) {
-		code[0] <<= 2;
-		code[1] <<= 2;
-		code[2] <<= 2;
-
-		/* Line 1 */
-		if ((odd_line_code & 0x80) != 0) {
-
-			code[0] |= 2;
-		}
-		if ((even_line_code & 0x80) != 0) {
-
-			code[0] |= 1;
-		}
-
-		/* Line 2 */
-		if ((odd_line_code & 0x08) != 0) {
-
-			code[1] |= 2;
-		}
-		if ((even_line_code & 0x08) != 0) {
-
-			code[1] |= 1;
-		}
+/*
+ * Indexed by the parities of the four bytes of a word, one bit each.
+ * Bits 0-1 are the xor of the offsets of the odd bytes within the word.
+ * Bits 2-7 are set if there is an odd number of them, to let the word
+ * offset through.
+ */
+const uint8_t hamming_line4[16] = {
+	0x00, 0xfc, 0xfd, 0x01, 0xfe, 0x02, 0x03, 0xff,
+	0xff, 0x03, 0x02, 0xfe, 0x01, 0xfd, 0xfc, 0x00,
+};
+
+/* Spreads a nibble to the even bits of a byte, for interleaving Px/Px' */
+static const uint8_t hamming_spread[16] = {
+	0x00, 0x01, 0x04, 0x05, 0x10, 0x11, 0x14, 0x15,
+	0x40, 0x41, 0x44, 0x45, 0x50, 0x51, 0x54, 0x55,
+};
+
+/* The finished (inverted) column byte of the code, by column sum */
+static const uint8_t hamming_column[256] = {
+	0xff, 0xab, 0xa7, 0xf3, 0x9b, 0xcf, 0xc3, 0x97,
+	0x97, 0xc3, 0xcf, 0x9b, 0xf3, 0xa7, 0xab, 0xff,
+	0x6b, 0x3f, 0x33, 0x67, 0x0f, 0x5b, 0x57, 0x03,
+	0x03, 0x57, 0x5b, 0x0f, 0x67, 0x33, 0x3f, 0x6b,
+	0x67, 0x33, 0x3f, 0x6b, 0x03, 0x57, 0x5b, 0x0f,
+	0x0f, 0x5b, 0x57, 0x03, 0x6b, 0x3f, 0x33, 0x67,
+	0xf3, 0xa7, 0xab, 0xff, 0x97, 0xc3, 0xcf, 0x9b,
+	0x9b, 0xcf, 0xc3, 0x97, 0xff, 0xab, 0xa7, 0xf3,
+	0x5b, 0x0f, 0x03, 0x57, 0x3f, 0x6b, 0x67, 0x33,
+	0x33, 0x67, 0x6b, 0x3f, 0x57, 0x03, 0x0f, 0x5b,
+	0xcf, 0x9b, 0x97, 0xc3, 0xab, 0xff, 0xf3, 0xa7,
+	0xa7, 0xf3, 0xff, 0xab, 0xc3, 0x97, 0x9b, 0xcf,
+	0xc3, 0x97, 0x9b, 0xcf, 0xa7, 0xf3, 0xff, 0xab,
+	0xab, 0xff, 0xf3, 0xa7, 0xcf, 0x9b, 0x97, 0xc3,
+	0x57, 0x03, 0x0f, 0x5b, 0x33, 0x67, 0x6b, 0x3f,
+	0x3f, 0x6b, 0x67, 0x33, 0x5b, 0x0f, 0x03, 0x57,
+	0x57, 0x03, 0x0f, 0x5b, 0x33, 0x67, 0x6b, 0x3f,
+	0x3f, 0x6b, 0x67, 0x33, 0x5b, 0x0f, 0x03, 0x57,
+	0xc3, 0x97, 0x9b, 0xcf, 0xa7, 0xf3, 0xff, 0xab,
+	0xab, 0xff, 0xf3, 0xa7, 0xcf, 0x9b, 0x97, 0xc3,
+	0xcf, 0x9b, 0x97, 0xc3, 0xab, 0xff, 0xf3, 0xa7,
+	0xa7, 0xf3, 0xff, 0xab, 0xc3, 0x97, 0x9b, 0xcf,
+	0x5b, 0x0f, 0x03, 0x57, 0x3f, 0x6b, 0x67, 0x33,
+	0x33, 0x67, 0x6b, 0x3f, 0x57, 0x03, 0x0f, 0x5b,
+	0xf3, 0xa7, 0xab, 0xff, 0x97, 0xc3, 0xcf, 0x9b,
+	0x9b, 0xcf, 0xc3, 0x97, 0xff, 0xab, 0xa7, 0xf3,
+	0x67, 0x33, 0x3f, 0x6b, 0x03, 0x57, 0x5b, 0x0f,
+	0x0f, 0x5b, 0x57, 0x03, 0x6b, 0x3f, 0x33, 0x67,
+	0x6b, 0x3f, 0x33, 0x67, 0x0f, 0x5b, 0x57, 0x03,
+	0x03, 0x57, 0x5b, 0x0f, 0x67, 0x33, 0x3f, 0x6b,
+	0xff, 0xab, 0xa7, 0xf3, 0x9b, 0xcf, 0xc3, 0x97,
+	0x97, 0xc3, 0xcf, 0x9b, 0xf3, 0xa7, 0xab, 0xff,
+};
+
+/*-
+ * Interleave the parity values of one block to obtain the following
+ * layout:
+ * Code[0] = Line1
+ * Code[1] = Line2
+ * Code[2] = Column
+ * Line = Px' Px P(x-1)- P(x-1) ...
+ * Column = P4' P4 P2' P2 P1' P1 PadBit PadBit
+ * and invert them (linux compatibility).
+ */
+static void
+hamming_code(uint32_t sum, uint8_t *code)
+{
+	uint8_t odd_line_code = sum >> 8;
+	uint8_t even_line_code = odd_line_code;
 
-		/* Column */
-		if ((odd_column_code & 0x04) != 0) {
+	if (popcount32(sum & 0xff) & 1)
+		even_line_code = ~even_line_code;
 
-			code[2] |= 2;
-		}
-		if ((even_column_code & 0x04) != 0) {
+	code[0] = ~(hamming_spread[odd_line_code >> 4] << 1 |
+	    hamming_spread[even_line_code >> 4]);
+	code[1] = ~(hamming_spread[odd_line_code & 15] << 1 |
+	    hamming_spread[even_line_code & 15]);
+	code[2] = hamming_column[sum & 0xff];
+}
 
-			code[2] |= 1;
+/**
+ * Calculates the 22-bit hamming codes for n consecutive 256-byte blocks of
+ * data, such as a NAND page, in one pass.
+ * \param data  Data buffer to calculate codes for.
+ * \param n     Number of blocks.
+ * \param code  Pointer to a buffer where the 3 * n code bytes are stored.
+ */
+void
+hamming_compute_page(const uint8_t *data, int n, uint8_t *code)
+{
+	uint32_t sums[HAMMING_PAGE_BLOCKS];
+	uint32_t buf[256 / 4];
+	int i, k;
+
+	for (; n > 0; n -= k) {
+		k = n < HAMMING_PAGE_BLOCKS ? n : HAMMING_PAGE_BLOCKS;
+
+		if (((uint32_t)data & 3) == 0)
+			hamming_sums(data, k, sums);
+		else {
+			/* Word loads need an aligned copy */
+			for (i = 0; i < k; i++) {
+				memcpy(buf, data + i * 256, 256);
+				hamming_sums(buf, 1, &sums[i]);
+			}
 		}
 
-		odd_line_code <<= 1;
-		even_line_code <<= 1;
-		odd_column_code <<= 1;
-		even_column_code <<= 1;
+		for (i = 0; i < k; i++, code += 3)
+			hamming_code(sums[i], code);
+		data += k * 256;
 	}
+}
 
-	/* Invert codes (linux compatibility) */
-	code[0] = ~code[0];
-	code[1] = ~code[1];
-	code[2] = ~code[2];
+/**
+ * Calculates the 22-bit hamming code for a 256-bytes block of data.
+ * \param data  Data buffer to calculate code for.
+ * \param code  Pointer to a buffer where the code should be stored.
+ */
+void
+hamming_compute_256(const uint8_t *data, uint8_t *code)
+{
+	hamming_compute_page(data, 1, code);
 }
 
 /**
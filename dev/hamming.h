@@ -78,8 +78,15 @@
 /* Multiple bits are incorrect in the data and they cannot be corrected. */
 #define HAMMING_ERROR_MULTIPLEBITS	3
 
+/* 256-byte blocks in a 2 KB NAND page */
+#define HAMMING_PAGE_BLOCKS		8
+
 uint8_t hamming_correct_256(uint8_t *, const uint8_t *, const uint8_t *);
 void hamming_compute_256(const uint8_t *data, uint8_t *code);
+void hamming_compute_page(const uint8_t *data, int n, uint8_t *code);
+
+/* dev/hamming_arm.s */
+void hamming_sums(const void *data, int n, uint32_t *sums);
 
 #endif /* HAMMING_H */
 
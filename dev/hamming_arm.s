@@ -0,0 +1,93 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2022, Eric Enright
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * dev/hamming_arm.s
+ *
+ * Inner loop of the NAND Hamming code, see hamming.c.  A 256-byte block
+ * is read a word at a time: the words are xored together for the column
+ * parities, and the parities of the four bytes in each word are folded
+ * into a nibble that indexes hamming_line4[] for the line code.
+ */
+
+	.text
+	.code 32
+	.align 4
+
+	.global hamming_sums
+	.func hamming_sums
+	/*
+	 * Entry: r0: data (word aligned), r1: number of 256-byte blocks,
+	 * r2: sums, one word per block
+	 *
+	 * Return: sums[i] holds the xor of all bytes of block i in bits 0-7
+	 * and the xor of the offsets of its odd parity bytes in bits 8-15
+	 */
+hamming_sums:
+	stmdb	sp!, {r4-r8,lr}
+	ldr	r4, =hamming_line4
+	ldr	r5, =0x01010101
+
+.Lham_block:
+	subs	r1, r1, #1
+	blt	.Lham_done
+	mov	r6, #0			@ r6 = xor of all words
+	mov	r7, #0			@ r7 = line code
+	mov	r3, #0			@ r3 = offset of the word
+
+.Lham_word:
+	ldr	ip, [r0], #4
+	eor	r6, r6, ip
+	eor	ip, ip, ip, lsr #4
+	eor	ip, ip, ip, lsr #2
+	eor	ip, ip, ip, lsr #1
+	and	ip, ip, r5		@ parity of each byte in its bit 0
+	orr	ip, ip, ip, lsr #7
+	orr	ip, ip, ip, lsr #14
+	and	ip, ip, #15		@ ip = byte parities, byte 0 in bit 0
+	ldrb	lr, [r4, ip]
+	orr	r8, r3, #3		@ word offset only counts if odd
+	and	lr, lr, r8
+	eor	r7, r7, lr
+	add	r3, r3, #4
+	cmp	r3, #256
+	blt	.Lham_word
+
+	eor	r6, r6, r6, lsr #16
+	eor	r6, r6, r6, lsr #8
+	and	r6, r6, #0xff
+	orr	r6, r6, r7, lsl #8
+	str	r6, [r2], #4
+	b	.Lham_block
+
+.Lham_done:
+	ldmia	sp!, {r4-r8,pc}
+	.endfunc
+
+	.end
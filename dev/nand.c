@@ -38,6 +38,7 @@
 #include "../arch/mmu.h"
 #include <sleep.h>
 #include <nand.h>
+#include <kstat.h>
 #include "hamming.h"
 
 #include <stdio.h> // @@@ removeme
@@ -152,7 +153,7 @@ void nand_read_page(uint32_t page, void *buf)
 {
 	char *p = (char *)buf;
 	int i;
-	uint8_t ecc[3];
+	uint8_t ecc[HAMMING_PAGE_BLOCKS * 3];
 
 	nand_select();
 
@@ -163,27 +164,32 @@ void nand_read_page(uint32_t page, void *buf)
 	
 	nand_deselect();
 
+	++kstat.nand.pages_read;
+
 	// Validate ECC, which is stored in the last
 	// 24 bytes of the page
-	for (i = 0; i < 8; ++i) {
-		hamming_compute_256(buf + (i * 256), ecc);
+	hamming_compute_page(buf, HAMMING_PAGE_BLOCKS, ecc);
 
+	for (i = 0; i < HAMMING_PAGE_BLOCKS; ++i) {
 		switch (hamming_correct_256(buf + (i * 256),
 				buf + NAND_PAGE_SIZE + 40 + (i * 3),
-				ecc)) {
+				ecc + (i * 3))) {
 		case 0:	// Valid ECC
 			// Nop
 			break;
 
 		case HAMMING_ERROR_SINGLEBIT:
+			++kstat.nand.ecc_corrected;
 			printf("Corrected single bit error, %d\r\n", i);
 			break;
 
 		case HAMMING_ERROR_ECC:
+			++kstat.nand.ecc_failed;
 			printf("ECC corrupted, %d\r\n", i);
 			break;
 
 		case HAMMING_ERROR_MULTIPLEBITS:
+			++kstat.nand.ecc_failed;
 			printf("Multi-bit error, %d\r\n", i);
 			break;
 		}
@@ -247,6 +253,8 @@ int nand_erase(uint32_t block)
 
 	nand_deselect();
 
+	++kstat.nand.blocks_erased;
+
 	return status;
 }
 
@@ -265,13 +273,11 @@ int nand_write_sector(uint32_t page, int sect, void *buf)
 {
 	uint8_t *p = (uint8_t *)buf;
 	int status, i;
-	uint8_t ecc1[3];
-	uint8_t ecc2[3];
+	uint8_t ecc[6];
 	int col;
 
 	// Calculate ECC
-	hamming_compute_256(p, ecc1);
-	hamming_compute_256(p + 256, ecc2);
+	hamming_compute_page(p, 2, ecc);
 
 	nand_select();
 
@@ -298,12 +304,8 @@ int nand_write_sector(uint32_t page, int sect, void *buf)
 
 	// ECC
 	nand_random_data_input(NAND_PAGE_SIZE + 40 + (sect * 6));
-	outb(NAND_DATA, ecc1[0]);
-	outb(NAND_DATA, ecc1[1]);
-	outb(NAND_DATA, ecc1[2]);
-	outb(NAND_DATA, ecc2[0]);
-	outb(NAND_DATA, ecc2[1]);
-	outb(NAND_DATA, ecc2[2]);
+	for (i = 0; i < 6; ++i)
+		outb(NAND_DATA, ecc[i]);
 
 	// Do it
 	nand_cmd(NAND_CMD_PROGRAM_PAGE_CONFIRM);
@@ -314,5 +316,7 @@ int nand_write_sector(uint32_t page, int sect, void *buf)
 
 	nand_deselect();
 
+	++kstat.nand.sectors_written;
+
 	return status;
 }
@@ -44,7 +44,6 @@
 #include <ohci.h>
 #include <usb.h>
 
-static void *_hcca = NULL;
 static struct hcca *hcca = NULL;
 
 static struct usb_hub root_hub;
@@ -481,6 +480,11 @@ void ohci_init(void)
 	int ctrl;
 	int fmInterval;
 
+	if (usb_init()) {
+		printf("Unable to initialize USB\r\n");
+		return;
+	}
+
 	// @@@ arch-specific!
 	// Enable clock to USB controller
 	outl(PwrCnt, inl(PwrCnt) | PwrCnt_USH_EN);
@@ -502,15 +506,12 @@ void ohci_init(void)
 		return;
 	}
 
-	// Initialize HCCA
-	_hcca = smalloc(512);	// 512 bytes guarantees we will get 256-byte alignment
-	if (_hcca == NULL) {
+	// Initialize HCCA, which must be 256-byte aligned (ref. section 4.4)
+	hcca = dma_alloc(sizeof(struct hcca), 256);
+	if (hcca == NULL) {
 		printf("Failed to allocate HCCA\r\n");
 		return;
 	}
-
-	// Align HCCA to 256-byte boundary (ref. section 4.4)
-	hcca = (struct hcca *)(_hcca + (256 - ((uint32_t)_hcca % 256)));
 	memset(hcca, 0, sizeof(struct hcca));
 
 	fmInterval = inl(HcFmInterval);
@@ -35,84 +35,82 @@
 
 #include <sys/uart.h>
 
-static inline void uart_fifo_add(struct uart_fifo *f,const void *buf,size_t len)
+#include <string.h>
+
+// Producer side: copy in as much of buf as fits, in at most two pieces
+static size_t uart_fifo_put(struct uart_fifo *f, const void *buf, size_t len)
 {
-	char *p = (char *)buf;
+	uint32_t tail = f->tail;
+	uint32_t off = tail & UART_FIFO_MASK;
+	size_t n;
 
-	// @@@ room for enhancement here, interrupts are disabled and this
-	// is slow!
-	do {
-		f->data[f->tail] = *p++;
+	n = uart_fifo_free(f);
+	if (len > n)
+		len = n;
 
-		if (++f->tail >= sizeof(f->data))
-			f->tail = 0;
-	} while (--len > 0);
-}
+	n = UART_FIFO_SIZE - off;
+	if (n > len)
+		n = len;
 
-static inline void uart_fifo_remove(struct uart_fifo *f, void *buf, size_t len)
-{
-	char *p = (char *)buf;
+	memcpy(f->data + off, buf, n);
+	memcpy(f->data, (const char *)buf + n, len - n);
 
-	// @@@ room for enhancement here, interrupts are disabled and this
-	// is slow!
-	do {
-		*p++ = f->data[f->head];
+	// Publish the data only once it is in place
+	uart_fifo_barrier();
+	f->tail = tail + len;
 
-		if (++f->head >= sizeof(f->data))
-			f->head = 0;
-	} while (--len > 0);
+	return len;
 }
 
-int uart_write(struct uart *uart, const void *buf, size_t len)
+// Consumer side: copy out up to len bytes, in at most two pieces
+static size_t uart_fifo_get(struct uart_fifo *f, void *buf, size_t len)
 {
-	int rc = 0;	// Default to no data written
-	int available;
+	uint32_t head = f->head;
+	uint32_t off = head & UART_FIFO_MASK;
+	size_t n;
 
-	// Disable transmit so we don't clash with the transmit queue
-	uart->uart_ops->disable_tx(uart);
+	n = uart_fifo_available(f);
+	if (len > n)
+		len = n;
 
-	available = uart_fifo_free(&uart->tx_fifo);
+	// Don't read data from before tail was seen to move
+	uart_fifo_barrier();
 
-	// Can we write any data?
-	if (available > 0) {
-		// Yes, how much?
-		if (len > available)
-			len = available;
+	n = UART_FIFO_SIZE - off;
+	if (n > len)
+		n = len;
 
-		uart_fifo_add(&uart->tx_fifo, buf, len);
+	memcpy(buf, f->data + off, n);
+	memcpy((char *)buf + n, f->data, len - n);
 
-		rc = len;
-	}
+	// Hand the space back only once it has been copied out
+	uart_fifo_barrier();
+	f->head = head + len;
 
-	// OK, data is ready to go
-	uart->uart_ops->enable_tx(uart);
-
-	return rc;
+	return len;
 }
 
-int uart_read(struct uart *uart, void *buf, size_t len)
+int uart_write(struct uart *uart, const void *buf, size_t len)
 {
-	int rc = 0;	// Default to no data read
-	int available;
+	size_t n;
 
-	// Disable receive so we don't clash with the receive queue
-	uart->uart_ops->disable_rx(uart);
+	n = uart_fifo_put(&uart->tx_fifo, buf, len);
 
-	available = uart_fifo_available(&uart->rx_fifo);
+	// Start the transmitter; the handler turns itself off once the FIFO
+	// is drained
+	if (n > 0)
+		uart->uart_ops->enable_tx(uart);
 
-	// Can we read any data?
-	if (available > 0) {
-		// Yes, how much?
-		if (len > available)
-			len = available;
-
-		uart_fifo_remove(&uart->rx_fifo, buf, len);
-
-		rc = len;
-	}
+	return n;
+}
 
-	// OK, done reading to re-enable receipt
-	uart->uart_ops->enable_rx(uart);
+int uart_read(struct uart *uart, void *buf, size_t len)
+{
+	return uart_fifo_get(&uart->rx_fifo, buf, len);
+}
 
-	return rc;
+// Returns 0 on success, -1 if the rate cannot be set
+int uart_set_baud(struct uart *uart, int baud)
+{
+	return uart->uart_ops->set_baud(uart, baud);
 }
@@ -33,13 +33,21 @@
  * Universal Serial Bus Driver
  */
 
+#include <sys/slab.h>
+
 #include <usb.h>
 #include <stdio.h>
+#include <crc.h>
 
 #define LANG_EN_US	0x0409
 
 uint8_t nextAddress = 1;
 
+// Token and request packets are handed to the HCD, so keep them on their
+// own cache lines
+static struct kmem_cache *usb_token_cache = NULL;
+static struct kmem_cache *usb_request_cache = NULL;
+
 struct list usb_devices = {
 	.next = NULL,
 	.prev = NULL,
@@ -78,87 +86,17 @@ char *usb_class_str[] = {
 };
 int usb_class_str_max = 9;	// Max index to usb_class_str
 
-//******************************************************************************
-//
-// CRC5() - Computes a USB CRC5 value given an input value.
-//          Ported from the Perl routine from the USB white paper entitled
-//          "CYCLIC REDUNDANCY CHECKS IN USB"
-//          www.usb.org/developers/whitepapers/crcdes.pdf
-//
-//          Ported by Ron Hemphill 01/20/06.
-//
-//  dwinput:    The input value.
-//  iBitcnt:    The number of bits represented in dwInput.
-//
-//  Returns:    The computed CRC5 value.
-//
-//  Examples (from the white paper):
-//      dwInput     iBitcnt     Returns:
-//      0x547       11          0x17
-//      0x2e5       11          0x1C
-//      0x072       11          0x0E
-//      0x400       11          0x17
-//
-//******************************************************************************
-#define INT_SIZE    32      // Assumes 32-bit integer size
-static unsigned usb_crc5(unsigned dwInput, int iBitcnt)
+int usb_init(void)
 {
-    const uint32_t poly5 = (0x05 << (INT_SIZE-5));
-    uint32_t crc5  = (0x1f << (INT_SIZE-5));
-    uint32_t udata = (dwInput << (INT_SIZE-iBitcnt));
-
-    if ( (iBitcnt<1) || (iBitcnt>INT_SIZE) )    // Validate iBitcnt
-        return 0xffffffff;
-
-    while (iBitcnt--)
-    {
-        if ( (udata ^ crc5) & (0x1<<(INT_SIZE-1)) ) // bit4 != bit4?
-        {
-            crc5 <<= 1;
-            crc5 ^= poly5;
-        }
-        else
-            crc5 <<= 1;
-
-        udata <<= 1;
-    }
+	usb_token_cache = kmem_cache_create("usb_token",
+		sizeof(struct usb_token_pkt), KMEM_CACHE_ALIGN, NULL);
+	usb_request_cache = kmem_cache_create("usb_request",
+		sizeof(struct usb_request_pkt), KMEM_CACHE_ALIGN, NULL);
 
-    // Shift back into position
-    crc5 >>= (INT_SIZE-5);
-
-    // Invert contents to generate crc field
-    crc5 ^= 0x1f;
-
-    return crc5;
-}
+	if (usb_token_cache == NULL || usb_request_cache == NULL)
+		return -1;
 
-static uint16_t usb_crc16(void *buffer, uint32_t count) 
-{ 
-	uint8_t *bp; 
-	uint32_t poly, a, b, newBit, lostBit; int i; 
-	poly = 0x8005; 
-	a = 0xffff; 
-	bp = buffer; 
-
-
-	while(count--) 
-	{ 
-		b = *(bp++); 
-		for(i = 0; i<8; i++) 
-		{ 
-			a <<= 1; 
-			newBit = (b & 1); 
-			b >>= 1; 
-			lostBit = a >> 16; 
-
-			if(newBit != lostBit) 
-				a ^= poly; 
-
-			a &= 0xffff; 
-		} 
-	} 
-
-	return(a^0xffff); 
+	return 0;
 }
 
 static inline int usb_token(struct usb_dev *dev, int pid, int ep)
@@ -166,7 +104,7 @@ static inline int usb_token(struct usb_dev *dev, int pid, int ep)
 	int crc5;
 	struct usb_token_pkt *token = NULL;
 
-	token = malloc(sizeof(struct usb_token_pkt));
+	token = kmem_cache_alloc(usb_token_cache);
 	if (token == NULL) {
 		printf("Unable to allocate SETUP token packet\r\n");
 		return -1;
@@ -174,11 +112,11 @@ static inline int usb_token(struct usb_dev *dev, int pid, int ep)
 	memset(token, 0, sizeof(struct usb_token_pkt));
 
 	// Construct and queue the token packet
-	crc5 = usb_crc5(dev->address << 4 | ep, 11);
+	crc5 = crc5_usb(dev->address << 4 | ep, 11);
 	usb_fill_token_pkt(token, pid, dev->address, ep, crc5);
 	if (dev->hcd->out(dev->address, 0, token, sizeof(struct usb_token_pkt))) {
 		printf("Unable to queue token\r\n");
-		free(token);
+		kmem_cache_free(usb_token_cache, token);
 		return -1;
 	}
 
@@ -197,7 +135,7 @@ static int usb_set_address(struct usb_dev *dev, int address)
 		return -1;
 
 	// Construct and queue the DATA packet
-	req = malloc(sizeof(struct usb_request_pkt));
+	req = kmem_cache_alloc(usb_request_cache);
 	if (req == NULL) {
 		printf("Unable to allocate token packet\r\n");
 		return -1;
@@ -210,7 +148,8 @@ static int usb_set_address(struct usb_dev *dev, int address)
 	req->req.wValue = address;
 	// req->req.wIndex = 0;
 	// req->req.wLength = 0;
-	req->crc16 = usb_crc16(&req->req, sizeof(struct usb_request_pkt) - 3);
+	req->crc16 = crc16_usb(0, &req->req,
+		sizeof(struct usb_request_pkt) - 3);
 
 	if (dev->hcd->out(dev->address, 0, req, sizeof(struct usb_request_pkt))) {
 		printf("Unable to queue SET_ADDRESS SETUP data\r\n");
@@ -235,7 +174,7 @@ static int usb_set_address(struct usb_dev *dev, int address)
 out_err:
 
 	if (req != NULL)
-		free(req);
+		kmem_cache_free(usb_request_cache, req);
 
 	return -1;
 }
@@ -252,7 +191,7 @@ static int usb_get_desc(struct usb_dev *dev,
 		return -1;
 
 	// Construct and queue the DATA packet
-	req = malloc(sizeof(struct usb_request_pkt));
+	req = kmem_cache_alloc(usb_request_cache);
 	if (req == NULL) {
 		printf("Unable to allocate token packet\r\n");
 		return -1;
@@ -266,7 +205,8 @@ static int usb_get_desc(struct usb_dev *dev,
 	req->req.wValue = type << 8;
 	// req->req.wIndex = 0;
 	req->req.wLength = 18;
-	req->crc16 = usb_crc16(&req->req, sizeof(struct usb_request_pkt) - 3);
+	req->crc16 = crc16_usb(0, &req->req,
+		sizeof(struct usb_request_pkt) - 3);
 
 	if (dev->hcd->out(dev->address, 0, req, sizeof(struct usb_request_pkt))) {
 		printf("Unable to queue GET_DESCRIPTOR data\r\n");
@@ -302,7 +242,7 @@ static int usb_get_string_desc(struct usb_dev *dev,
 		return -1;
 
 	// Construct and queue the DATA packet
-	req = malloc(sizeof(struct usb_request_pkt));
+	req = kmem_cache_alloc(usb_request_cache);
 	if (req == NULL) {
 		printf("Unable to allocate token packet\r\n");
 		return -1;
@@ -316,7 +256,8 @@ static int usb_get_string_desc(struct usb_dev *dev,
 	req->req.wValue = (USB_DESC_STRING << 8) | idx;
 	// req->req.wIndex = 0;
 	req->req.wLength = 18;
-	req->crc16 = usb_crc16(&req->req, sizeof(struct usb_request_pkt) - 3);
+	req->crc16 = crc16_usb(0, &req->req,
+		sizeof(struct usb_request_pkt) - 3);
 
 	if (dev->hcd->out(dev->address, 0, req, sizeof(struct usb_request_pkt))) {
 		printf("Unable to queue GET_DESCRIPTOR data\r\n");
@@ -0,0 +1,203 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2022, Eric Enright
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * host/bench.c
+ *
+ * Host build of the benchmarks for the portable parts of lib/ and dev/,
+ * printing the same lines as user/bench.c:
+ *
+ *	bench <name> size=<bytes> n=<ops> us=<total> <metric>=<value>
+ *
+ * The assembly loops are replaced by host/kernels.c, so this measures the
+ * C around them and checks the results; it says nothing about the
+ * target's speed.  Comparing two builds of the same change does.
+ *
+ * This file is built against the host C library rather than include/, so
+ * the ertos functions are declared here with fixed width types.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// lib/crc.c
+int crc5_usb(uint32_t data, int bits);
+uint16_t crc16_usb(uint16_t crc, const void *buf, uint32_t len);
+uint32_t crc32(uint32_t crc, const void *buf, uint32_t len);
+uint32_t crc32_byte(uint32_t crc, const void *buf, uint32_t len);
+
+// dev/hamming.c
+uint8_t hamming_correct_256(uint8_t *, const uint8_t *, const uint8_t *);
+void hamming_compute_256(const uint8_t *data, uint8_t *code);
+void hamming_compute_page(const uint8_t *data, int n, uint8_t *code);
+
+#define HAMMING_ERROR_SINGLEBIT	1	// See dev/hamming.h
+#define PAGE_BLOCKS		8
+
+#define BENCH_BUF_SIZE	8192
+#define BENCH_REPS	2000
+
+static uint8_t bench_buf[BENCH_BUF_SIZE + 4];
+static int failed = 0;
+
+static uint32_t now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void bench_report_bw(const char *name, int size, int n, uint32_t us)
+{
+	uint64_t bytes = (uint64_t)size * n;
+
+	if (us == 0)
+		us = 1;
+
+	printf("bench %s size=%d n=%d us=%u kB_per_s=%llu\n", name, size, n,
+		us, (unsigned long long)(bytes * 1000 / us));
+}
+
+static void check(int ok, const char *what)
+{
+	if (!ok) {
+		printf("FAIL %s\n", what);
+		failed = 1;
+	}
+}
+
+static void check_crc(void)
+{
+	const char *s = "123456789";
+	uint32_t off, len;
+
+	// Catalogue check values
+	check(crc32(0, s, 9) == 0xcbf43926, "crc32 check value");
+	check(crc16_usb(0, s, 9) == 0xb4c8, "crc16_usb check value");
+
+	// The word loop has to agree with the byte loop at every alignment
+	for (off = 0; off < 4; ++off)
+		for (len = 0; len < 64; ++len)
+			check(crc32(0, bench_buf + off, len) ==
+				crc32_byte(0, bench_buf + off, len),
+				"crc32 against crc32_byte");
+}
+
+static void check_hamming(void)
+{
+	uint8_t *p = bench_buf;
+	uint8_t page[PAGE_BLOCKS * 3], code[3], fixed[3];
+	uint8_t saved[256];
+	int i;
+
+	// A page at a time has to match a block at a time, aligned or not
+	hamming_compute_page(p, PAGE_BLOCKS, page);
+	for (i = 0; i < PAGE_BLOCKS; ++i) {
+		hamming_compute_256(p + i * 256, code);
+		check(memcmp(code, page + i * 3, 3) == 0, "hamming page");
+	}
+	hamming_compute_page(p + 1, PAGE_BLOCKS, page);
+	for (i = 0; i < PAGE_BLOCKS; ++i) {
+		hamming_compute_256(p + 1 + i * 256, code);
+		check(memcmp(code, page + i * 3, 3) == 0,
+			"hamming unaligned page");
+	}
+
+	// Every single bit error has to be found and put right
+	hamming_compute_256(p, code);
+	memcpy(saved, p, 256);
+	for (i = 0; i < 256 * 8; ++i) {
+		p[i >> 3] ^= 1 << (i & 7);
+		hamming_compute_256(p, fixed);
+		check(hamming_correct_256(p, code, fixed) ==
+			HAMMING_ERROR_SINGLEBIT, "hamming single bit error");
+		check(memcmp(p, saved, 256) == 0, "hamming correction");
+		memcpy(p, saved, 256);
+	}
+}
+
+static void bench_crc(void)
+{
+	volatile uint32_t sink;
+	uint32_t t;
+	int i;
+
+	t = now_us();
+	for (i = 0; i < BENCH_REPS; ++i)
+		sink = crc32(0, bench_buf, BENCH_BUF_SIZE);
+	bench_report_bw("crc32", BENCH_BUF_SIZE, BENCH_REPS, now_us() - t);
+
+	t = now_us();
+	for (i = 0; i < BENCH_REPS; ++i)
+		sink = crc32_byte(0, bench_buf, BENCH_BUF_SIZE);
+	bench_report_bw("crc32_byte", BENCH_BUF_SIZE, BENCH_REPS,
+		now_us() - t);
+
+	t = now_us();
+	for (i = 0; i < BENCH_REPS; ++i)
+		sink = crc16_usb(0, bench_buf, BENCH_BUF_SIZE);
+	bench_report_bw("crc16_usb", BENCH_BUF_SIZE, BENCH_REPS, now_us() - t);
+
+	(void)sink;
+}
+
+static void bench_hamming(void)
+{
+	uint8_t code[PAGE_BLOCKS * 3];
+	uint32_t t;
+	int i;
+
+	t = now_us();
+	for (i = 0; i < BENCH_REPS * 4; ++i)
+		hamming_compute_page(bench_buf, PAGE_BLOCKS, code);
+	bench_report_bw("hamming_page", PAGE_BLOCKS * 256, BENCH_REPS * 4,
+		now_us() - t);
+}
+
+int main(void)
+{
+	int i;
+
+	srand(1);
+	for (i = 0; i < sizeof(bench_buf); ++i)
+		bench_buf[i] = rand();
+
+	check_crc();
+	check_hamming();
+
+	bench_crc();
+	bench_hamming();
+
+	return failed;
+}
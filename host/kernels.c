@@ -0,0 +1,94 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2022, Eric Enright
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * host/kernels.c
+ *
+ * Portable C versions of the assembly inner loops, for the host build.
+ * Each does the same job as its ARM counterpart, so the C around it in
+ * lib/ and dev/ runs unchanged.
+ */
+
+#include <types.h>
+#include <crc.h>
+
+#include "../dev/hamming.h"
+
+extern const uint32_t crc32_table[4][256];
+extern const uint8_t hamming_line4[16];
+
+// See lib/crc_arm.s
+uint32_t crc32_words(uint32_t crc, const void *buf, size_t n)
+{
+	const uint8_t *p = buf;
+
+	while (n-- > 0) {
+		crc ^= p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+		crc = crc32_table[3][crc & 0xff] ^
+			crc32_table[2][(crc >> 8) & 0xff] ^
+			crc32_table[1][(crc >> 16) & 0xff] ^
+			crc32_table[0][crc >> 24];
+		p += 4;
+	}
+
+	return crc;
+}
+
+// See dev/hamming_arm.s
+void hamming_sums(const void *data, int n, uint32_t *sums)
+{
+	const uint8_t *p = data;
+	uint32_t col, line, w;
+	int i;
+
+	for (; n > 0; --n, ++sums) {
+		col = 0;
+		line = 0;
+
+		for (i = 0; i < 256; i += 4, p += 4) {
+			w = p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+			col ^= w;
+
+			// Parity of each byte in its bit 0, then one bit each
+			w ^= w >> 4;
+			w ^= w >> 2;
+			w ^= w >> 1;
+			w &= 0x01010101;
+			w |= w >> 7;
+			w |= w >> 14;
+
+			// The word offset only counts if odd
+			line ^= hamming_line4[w & 15] & (i | 3);
+		}
+
+		col ^= col >> 16;
+		col ^= col >> 8;
+		*sums = (col & 0xff) | (line & 0xff) << 8;
+	}
+}
@@ -0,0 +1,52 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2022, Eric Enright
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * include/crc.h
+ *
+ * Cyclic redundancy checks, see lib/crc.c.
+ *
+ * crc16_usb() and crc32() may be run over a buffer in pieces: pass 0 to
+ * start, then the previous result to continue.
+ */
+
+#ifndef _CRC_H
+#define _CRC_H
+
+#include <types.h>
+
+int crc5_usb(uint32_t data, int bits);
+uint16_t crc16_usb(uint16_t crc, const void *buf, size_t len);
+uint32_t crc32(uint32_t crc, const void *buf, size_t len);
+uint32_t crc32_byte(uint32_t crc, const void *buf, size_t len);
+
+/* lib/crc_arm.s */
+uint32_t crc32_words(uint32_t crc, const void *buf, size_t n);
+
+#endif // !_CRC_H
@@ -37,21 +37,161 @@
 #define _KSTAT_H
 
 #include <types.h>
+#include <seqlock.h>
 #include "../net/dll/eth.h"
 
+// Bumped whenever a section is added to the end of struct kstat or
+// struct netstat.  Existing fields never move, so a consumer built against
+// an older version can still use the prefix it knows about.
+#define KSTAT_VERSION	6
+#define NETSTAT_VERSION	1
+
+#define NETSTAT_IFS	4	// Interfaces reported by netstat_get()
+
 struct netstat {
+	uint32_t version;		// NETSTAT_VERSION
+	uint32_t size;			// sizeof(struct netstat)
+	int num_if;			// Valid entries in eth[]
+
 	struct {
 		char name[EN_ETH_IF_NAMESIZE];
 		struct en_eth_stats stats;
-	} eth;
+	} eth[NETSTAT_IFS];
+};
+
+#define IRQSTAT_VECTORS	32	// VIC1 and VIC2 vectored slots
+#define IRQSTAT_BUCKETS	12	// Bucket n counts [2^(n-1), 2^n) us
+#define IRQSTAT_UNUSED	(-1)	// irq of a free slot; 0 is a real source
+
+// Per-vector interrupt statistics, times in microseconds
+struct irqstat_vec {
+	int irq;			// IRQSTAT_UNUSED if the slot is unused
+	uint32_t count;
+	uint32_t time_max;		// Longest time spent in the handler
+	uint32_t time_hist[IRQSTAT_BUCKETS];
+	uint32_t lat_max;		// Longest assertion to handler latency
+	uint32_t lat_hist[IRQSTAT_BUCKETS];
+};
+
+struct irqstat {
+	struct irqstat_vec vec[IRQSTAT_VECTORS];
+	uint32_t irqoff_max;		// Longest cli()/sti() section
+	uint32_t irqoff_pc;		// Caller of sti() ending it
+	uint32_t svc_max;		// Longest system call
+	uint32_t svc_num;		// and its number
+};
+
+struct kstat_sched {
+	uint32_t switches;		// Context switches
+	uint32_t syscalls;		// System calls
+	uint32_t wakeups;		// Processes made runnable
+};
+
+#define KSTAT_MEM_CLASSES	16
+
+struct kstat_mem_class {
+	uint32_t size;			// Chunk size, 0 if unused
+	uint32_t total;			// Chunks in the class
+	uint32_t in_use;		// Chunks allocated
+	uint32_t peak;			// Most chunks ever allocated
+	uint32_t exhausted;		// Requests passed up to a larger class
+};
+
+struct kstat_mem {
+	uint32_t heap_size;		// Bytes managed in total
+	uint32_t smalloc_used;		// Bytes permanently allocated
+	uint32_t failures;		// Requests which returned NULL
+	struct kstat_mem_class class[KSTAT_MEM_CLASSES];
+};
+
+#define KSTAT_UARTS	3
+
+struct kstat_uart {
+	uint32_t rx_bytes;
+	uint32_t tx_bytes;
+	uint32_t rx_dropped;		// Lost to a full receive FIFO
+	uint32_t interrupts;
+};
+
+// How well the hardware FIFOs batch up UART traffic, by the same index as
+// kstat.uart[]
+struct kstat_uart_fifo {
+	uint32_t rx_interrupts;		// RX FIFO half full or timed out
+	uint32_t tx_interrupts;		// TX FIFO half empty
+	uint32_t rx_overruns;		// Lost to a full RX FIFO in hardware
+};
+
+struct kstat_nand {
+	uint32_t pages_read;
+	uint32_t sectors_written;
+	uint32_t blocks_erased;
+	uint32_t ecc_corrected;		// Single bit errors fixed
+	uint32_t ecc_failed;		// Uncorrectable or corrupt ECC
+};
+
+#define KSTAT_SLABS	8
+#define KSTAT_NAMESIZE	12
+
+// Object caches, see kernel/slab.c
+struct kstat_slab {
+	char name[KSTAT_NAMESIZE];	// Empty if the slot is unused
+	uint32_t size;			// Object size including padding
+	uint32_t total;			// Objects carved from slabs
+	uint32_t in_use;
+	uint32_t peak;
+	uint32_t slabs;			// Slabs allocated
+	uint32_t failures;		// Allocations which returned NULL
+};
+
+// Variable sized allocation pool, see kernel/tlsf.c
+struct kstat_pool {
+	uint32_t size;			// Bytes available when empty
+	uint32_t used;			// Bytes allocated
+	uint32_t peak;			// Most bytes ever allocated
+};
+
+// Memory pressure, see kernel/reclaim.c
+struct kstat_reclaim {
+	uint32_t pressure;		// Times a low-water mark was crossed
+	uint32_t runs;			// Background shrinker passes
+	uint32_t direct;		// Passes by allocations about to fail
+	uint32_t freed;			// Objects released by shrinkers
+};
+
+// Boot timing, in debug timer ticks (about 1us) from entry to main()
+struct kstat_boot {
+	uint32_t mem_init;		// Time until mem_init() returned
+	uint32_t first_task;		// Time until the first user task ran
 };
 
 struct kstat {
+	uint32_t version;		// KSTAT_VERSION
+	uint32_t size;			// sizeof(struct kstat)
+	struct seqcount seq;		// See seqlock.h
+
 	uint32_t isr_recursion;
+	struct kstat_sched sched;
+	struct kstat_mem mem;
+	struct irqstat irq;
+	struct kstat_uart uart[KSTAT_UARTS];
+	struct kstat_nand nand;
+	struct kstat_slab slab[KSTAT_SLABS];	// Version 2
+	struct kstat_pool pool;			// Version 3
+	struct kstat_reclaim reclaim;		// Version 4
+	struct kstat_boot boot;			// Version 5
+	struct kstat_uart_fifo uart_fifo[KSTAT_UARTS];	// Version 6
 };
 
-// syscall
+// kernel/main.c
+extern struct kstat kstat;
+
+// Writers updating more than a single counter bracket the update with these
+#define kstat_write_begin()	seq_write_begin(&kstat.seq)
+#define kstat_write_end()	seq_write_end(&kstat.seq)
+
+// lib/kstat.c, safe to call at any rate; neither blocks the kernel
 int kstat_get(struct kstat *);
 int netstat_get(struct netstat *);
+void netstat_copy(struct netstat *);
 
 #endif /* !_KSTAT_H */
@@ -38,6 +38,8 @@
 
 #define STDOUT_SIZE 1024
 
+struct tlsf;
+
 // Various user-visible process-specific items
 struct self {
 	struct {
@@ -46,6 +48,8 @@ struct self {
 		int buf_enable;
 		int buf_last;
 	} stdout;
+
+	struct tlsf *heap;		// User heap, see lib/heap.c
 };
 
 #define stdio_buf_disable() 					\
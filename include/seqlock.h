@@ -0,0 +1,89 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2022, Eric Enright
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * include/seqlock.h
+ *
+ * Sequence counters, for data which is written rarely relative to how
+ * often it is read, and where readers must never hold up a writer.
+ *
+ * A writer bumps the count to odd before updating and back to even after.
+ * A reader samples the count, copies the data and then checks the count
+ * again, retrying if a write was in progress or happened in between.
+ *
+ * Writers must not be preempted by another writer of the same data: they
+ * run in an interrupt handler, a system call or with IRQs masked.
+ */
+
+#ifndef _SEQLOCK_H
+#define _SEQLOCK_H
+
+#include <types.h>
+
+struct seqcount {
+	volatile uint32_t seq;
+};
+
+// Keep the compiler from moving loads and stores across the counter
+#define seq_barrier()	__asm__ __volatile__("" : : : "memory")
+
+static inline void seq_write_begin(struct seqcount *s)
+{
+	++s->seq;
+	seq_barrier();
+}
+
+static inline void seq_write_end(struct seqcount *s)
+{
+	seq_barrier();
+	++s->seq;
+}
+
+static inline uint32_t seq_read_begin(const struct seqcount *s)
+{
+	uint32_t seq;
+
+	// Wait out a writer which was preempted mid-update
+	while ((seq = s->seq) & 1)
+		;
+
+	seq_barrier();
+
+	return seq;
+}
+
+// Returns non-zero if the data read since seq_read_begin() may be torn
+static inline int seq_read_retry(const struct seqcount *s, uint32_t seq)
+{
+	seq_barrier();
+
+	return s->seq != seq;
+}
+
+#endif // !_SEQLOCK_H
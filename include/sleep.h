@@ -49,6 +49,13 @@ struct alarm {
 	int oneshot;		// Non-zero if this should fire only once
 };
 
+// The top byte of the event mask is reserved for events raised by the
+// kernel.  Tasks pick their own events from EVENT_USER_MASK.
+#define EVENT_KERNEL_MASK	0xFF000000
+#define EVENT_USER_MASK		0x00FFFFFF
+
+#define EVENT_MEM_PRESSURE	0x80000000	// Memory is running short
+
 // Public system calls
 int wait(struct completion *c);
 int wake(struct completion *c);
@@ -61,6 +68,9 @@ int alarm(struct alarm *a);
 // Sleep forever
 int reset(void);
 
+// Stop the calling process for good, releasing its heap
+int exit(void);
+
 // Private system calls
 int _user_timer_trampoline_done(void);
 
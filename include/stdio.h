@@ -33,10 +33,16 @@
 // Stolen from host libc
 #include <stdarg.h>
 
+#include <types.h>
+
 void puts(const char *s);
 void putchar(char c);
-int printf(char *fmt, ...);
+int printf(const char *fmt, ...);
+int vprintf(const char *fmt, va_list ap);
+int snprintf(char *buf, size_t size, const char *fmt, ...);
+int vsnprintf(char *buf, size_t size, const char *fmt, va_list ap);
 char *gets(char *s, int size);
 int getchar(void);
+void flush(void);
 
 #endif // !_STDIO_H
@@ -32,8 +32,8 @@
 
 #include <types.h>
 
-void memcpy(void *dest, const void *src, size_t n);
-void memmove(void *dest, const void *src, size_t n);
+void *memcpy(void *dest, const void *src, size_t n);
+void *memmove(void *dest, const void *src, size_t n);
 void *memset(void *s, int c, size_t n);
 char *strcpy(char *dest, const char *src);
 char *strncpy(char *dest, const char *src, size_t n);
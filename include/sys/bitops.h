@@ -0,0 +1,75 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2022, Eric Enright
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _BITOPS_H
+#define _BITOPS_H
+
+#include <types.h>
+
+// The ARM920T (ARMv4T) has no clz instruction and libgcc is not linked in,
+// so __builtin_clz() is not available.  A five step binary search is used
+// instead.
+
+// Find last (most significant) set bit, 1-based.  fls(0) is 0.
+static inline int fls(uint32_t x)
+{
+	int r = 32;
+
+	if (x == 0)
+		return 0;
+
+	if (!(x & 0xFFFF0000)) {
+		x <<= 16;
+		r -= 16;
+	}
+	if (!(x & 0xFF000000)) {
+		x <<= 8;
+		r -= 8;
+	}
+	if (!(x & 0xF0000000)) {
+		x <<= 4;
+		r -= 4;
+	}
+	if (!(x & 0xC0000000)) {
+		x <<= 2;
+		r -= 2;
+	}
+	if (!(x & 0x80000000))
+		r -= 1;
+
+	return r;
+}
+
+// Find first (least significant) set bit, 1-based.  ffs(0) is 0.
+static inline int ffs(uint32_t x)
+{
+	return fls(x & -x);
+}
+
+#endif // !_BITOPS_H
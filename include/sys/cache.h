@@ -0,0 +1,162 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2022, Eric Enright
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * include/sys/cache.h
+ *
+ * ARM920T cache maintenance for drivers.  The caches are only turned on
+ * along with the MMU, so without ENABLE_MMU these do nothing.
+ *
+ * Buffers a device reads must be cleaned before the device is started,
+ * and buffers a device writes must be invalidated before the CPU looks at
+ * them.  Memory from dma_alloc() is uncached and needs neither.
+ */
+
+#ifndef _CACHE_H
+#define _CACHE_H
+
+#include "../../config.h"
+
+#include <types.h>
+
+#define CACHE_LINE_SHIFT	5
+#define CACHE_LINE		(1 << CACHE_LINE_SHIFT)
+
+// 16k D-cache: 8 segments of 64 lines
+#define DCACHE_SEGMENTS		8
+#define DCACHE_INDEXES		64
+
+#ifdef ENABLE_MMU
+
+// Wait for the write buffer to empty
+static inline void drain_write_buffer(void)
+{
+	__asm__ __volatile__(
+		"mcr	p15, 0, %0, c7, c10, 4\n"
+		:
+		: "r" (0)
+		: "memory");
+}
+
+// Write back dirty lines covering [p, p + len) to memory
+static inline void dcache_clean_range(void *p, size_t len)
+{
+	uint32_t a = (uint32_t)p & ~(CACHE_LINE - 1);
+	uint32_t end = (uint32_t)p + len;
+
+	for (; a < end; a += CACHE_LINE)
+		__asm__ __volatile__(
+			"mcr	p15, 0, %0, c7, c10, 1\n"
+			:
+			: "r" (a)
+			: "memory");
+
+	drain_write_buffer();
+}
+
+// Write back and discard lines covering [p, p + len)
+static inline void dcache_flush_range(void *p, size_t len)
+{
+	uint32_t a = (uint32_t)p & ~(CACHE_LINE - 1);
+	uint32_t end = (uint32_t)p + len;
+
+	for (; a < end; a += CACHE_LINE)
+		__asm__ __volatile__(
+			"mcr	p15, 0, %0, c7, c14, 1\n"
+			:
+			: "r" (a)
+			: "memory");
+
+	drain_write_buffer();
+}
+
+// Discard lines covering [p, p + len) so the CPU rereads memory.  Lines
+// only partly covered may hold someone else's dirty data, so those are
+// written back first.
+static inline void dcache_inval_range(void *p, size_t len)
+{
+	uint32_t a = (uint32_t)p;
+	uint32_t end = (uint32_t)p + len;
+
+	if (a & (CACHE_LINE - 1)) {
+		dcache_flush_range((void *)a, 1);
+		a = (a + CACHE_LINE) & ~(CACHE_LINE - 1);
+	}
+
+	if (end & (CACHE_LINE - 1)) {
+		dcache_flush_range((void *)end, 1);
+		end &= ~(CACHE_LINE - 1);
+	}
+
+	for (; a < end; a += CACHE_LINE)
+		__asm__ __volatile__(
+			"mcr	p15, 0, %0, c7, c6, 1\n"
+			:
+			: "r" (a)
+			: "memory");
+}
+
+// Write back and discard the whole D-cache, by segment and index
+static inline void dcache_flush_all(void)
+{
+	uint32_t seg, idx;
+
+	for (seg = 0; seg < DCACHE_SEGMENTS; ++seg)
+		for (idx = 0; idx < DCACHE_INDEXES; ++idx)
+			__asm__ __volatile__(
+				"mcr	p15, 0, %0, c7, c14, 2\n"
+				:
+				: "r" ((idx << 26) | (seg << CACHE_LINE_SHIFT))
+				: "memory");
+
+	drain_write_buffer();
+}
+
+// Discard the whole I-cache, after writing code or vectors
+static inline void icache_inval(void)
+{
+	__asm__ __volatile__(
+		"mcr	p15, 0, %0, c7, c5, 0\n"
+		:
+		: "r" (0)
+		: "memory");
+}
+
+#else
+
+#define drain_write_buffer()		do { } while (0)
+#define dcache_clean_range(p, len)	do { (void)(p); (void)(len); } while (0)
+#define dcache_flush_range(p, len)	do { (void)(p); (void)(len); } while (0)
+#define dcache_inval_range(p, len)	do { (void)(p); (void)(len); } while (0)
+#define dcache_flush_all()		do { } while (0)
+#define icache_inval()			do { } while (0)
+
+#endif // ENABLE_MMU
+
+#endif // !_CACHE_H
@@ -30,6 +30,39 @@
 #ifndef _IRQ_H
 #define _IRQ_H
 
+#include <types.h>
+
+#define ARM_NO_IRQ	0x80	// CPSR IRQ disable bit
+#define ARM_MODE_MASK	0x1f	// CPSR mode bits
+#define ARM_MODE_USR	0x10
+
+// Mask IRQs, returning the previous CPSR for irq_restore().  These only
+// have an effect in privileged modes; the CPSR control bits can not be
+// changed from user mode.
+static inline uint32_t irq_save(void)
+{
+	uint32_t flags, tmp;
+
+	__asm__ __volatile__(
+		"mrs	%0, cpsr\n"
+		"orr	%1, %0, #0x80\n"
+		"msr	cpsr_c, %1\n"
+		: "=r" (flags), "=r" (tmp)
+		:
+		: "memory");
+
+	return flags;
+}
+
+static inline void irq_restore(uint32_t flags)
+{
+	__asm__ __volatile__(
+		"msr	cpsr_c, %0\n"
+		:
+		: "r" (flags)
+		: "memory");
+}
+
 // arch/irq.s
 void sti(void);
 void cli(void);
@@ -37,7 +70,14 @@ void enable_irq(int irq);
 void disable_irq(int irq);
 
 // kernel/irq.c
-void c_irq(void);
+extern uint32_t irq_pc;
+
+void c_irq(uint32_t *frame);
 int register_irq_handler(int irq, void *handler, int fast);
+int irq_set_latency_probe(int irq, uint32_t (*probe)(void));
+void irqoff_begin(uint32_t cpsr);
+void irqoff_end(uint32_t cpsr, uint32_t pc);
+void irqstat_svc(uint32_t num, uint32_t t);
+void irqstat_reset(void);
 
 #endif // !_IRQ_H
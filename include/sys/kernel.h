@@ -32,12 +32,13 @@
 
 #include <types.h>
 #include <proc.h>
+#include <div.h>
 
 #define HZ 100
 
 // Must match up with HZ
 #define clkticks_to_ms(x) (x * 10)
-#define ms_to_clkticks(x) ((unsigned)x / 10)
+#define ms_to_clkticks(x) udiv10(x)
 
 extern struct kstat kstat;
 
@@ -85,4 +85,6 @@ static inline void bfifo_free(struct bfifo *f)
 	free(f);
 }
 
+#define bfifo_empty(f) ((f)->free >= (f)->size)
+
 #endif // !_LIST_H
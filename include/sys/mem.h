@@ -30,14 +30,50 @@
 #ifndef _MEM_H
 #define _MEM_H
 
+#include "../../config.h"
+
 #include <types.h>
 
 extern void *_heap_start;
 extern size_t _heap_size;
 
+// Size classes are set up in config.h.in
+#define ALLOC_MIN	(1 << ALLOC_MIN_SHIFT)
+#define ALLOC_MAX	(ALLOC_MIN << (ALLOC_STEPS - 1))
+
+#if ALLOC_STEPS > 16
+#	error "At most 16 size classes are supported"
+#endif
+
 void mem_init(void);
-void * malloc(size_t size);
+void * (malloc)(size_t size);
+void * mem_alloc_class(int cls, size_t size);
+void * memalign(size_t align, size_t size);
+void * realloc(void *ptr, size_t size);
 void * smalloc(size_t size);
+void * dma_alloc(size_t size, size_t align);
 void free(void *ptr);
+int mem_low_water(size_t size, int chunks);
+
+// Place a static object in the uncached DMA region.  Unlike .bss it is not
+// cleared until mem_init() runs.
+#define __dma	__attribute__((section(".dma")))
+
+// Class serving size bytes, for 0 < size <= ALLOC_MAX.  A constant
+// expression when size is one, so it folds even without optimization.
+#define _mem_fits(s, n)	((s) <= (ALLOC_MIN << (n)))
+#define mem_size_class(s) \
+	(_mem_fits(s, 0) ? 0 : _mem_fits(s, 1) ? 1 : _mem_fits(s, 2) ? 2 : \
+	 _mem_fits(s, 3) ? 3 : _mem_fits(s, 4) ? 4 : _mem_fits(s, 5) ? 5 : \
+	 _mem_fits(s, 6) ? 6 : _mem_fits(s, 7) ? 7 : _mem_fits(s, 8) ? 8 : \
+	 _mem_fits(s, 9) ? 9 : _mem_fits(s, 10) ? 10 : _mem_fits(s, 11) ? 11 : \
+	 _mem_fits(s, 12) ? 12 : _mem_fits(s, 13) ? 13 : _mem_fits(s, 14) ? 14 : 15)
+
+// Nearly every allocation is of a sizeof() constant.  Those resolve their
+// class at compile time and go straight to its free list, skipping the
+// size lookup and the pool checks.  Everything else takes the normal path.
+#define malloc(size) \
+	(__builtin_constant_p(size) && (size) > 0 && (size) <= ALLOC_MAX ? \
+		mem_alloc_class(mem_size_class(size), (size)) : (malloc)(size))
 
 #endif // !_MEM_H
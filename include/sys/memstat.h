@@ -0,0 +1,119 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2022, Eric Enright
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * include/sys/memstat.h
+ *
+ * Allocator statistics.  Every allocation is attributed to the current
+ * process and to the PC that called the allocator, so live and peak usage
+ * can be broken down per task and per call site.  Requested sizes are
+ * kept alongside so internal fragmentation of each size class is visible.
+ *
+ * Statistics are enabled with CONFIG_MEMSTAT in components.
+ */
+
+#ifndef _SYS_MEMSTAT_H
+#define _SYS_MEMSTAT_H
+
+#include "../../config.h"
+
+#include <types.h>
+#include <kstat.h>
+
+#define MEMSTAT_PIDS	16	// Processes tracked individually
+#define MEMSTAT_SITES	64	// Call sites, must be a power of two
+#define MEMSTAT_POOL	256	// Live pool allocations, power of two
+
+#define MEMSTAT_CLASS_POOL	0xFF	// memstat_rec.cls of pool allocations
+
+// Bytes are what the allocation consumes, not what was requested
+struct memstat_pid {
+	uint16_t pid;
+	uint16_t used;			// Non-zero once the slot is taken
+	uint32_t live;			// Bytes allocated
+	uint32_t peak;			// Most bytes ever allocated
+	uint32_t allocs;
+	uint32_t failures;
+};
+
+struct memstat_site {
+	uint32_t pc;			// Caller of the allocator, 0 if unused
+	uint32_t live;			// Bytes allocated
+	uint32_t count;			// Allocations live
+	uint32_t allocs;
+	uint32_t failures;
+};
+
+// Per allocation record
+struct memstat_rec {
+	uint32_t pc;
+	uint32_t req;			// Bytes requested
+	uint16_t pid;
+	uint8_t cls;			// Size class, or MEMSTAT_CLASS_POOL
+	uint8_t pad;
+};
+
+struct memstat {
+	struct memstat_pid pid[MEMSTAT_PIDS];
+	struct memstat_pid other;	// Processes beyond the table
+	struct memstat_site site[MEMSTAT_SITES];
+	uint32_t requested[KSTAT_MEM_CLASSES];	// Live bytes requested
+	uint32_t pool_requested;
+	uint32_t untracked;		// Pool allocations beyond MEMSTAT_POOL
+	uint32_t sites_dropped;		// Allocations beyond MEMSTAT_SITES
+};
+
+#ifdef CONFIG_MEMSTAT
+
+// kernel/memstat.c, called with IRQs masked
+extern struct memstat memstat;
+
+int memstat_init(int chunks);
+void memstat_chunk_alloc(int idx, int cls, size_t req, size_t size,
+	uint32_t pc);
+void memstat_chunk_free(int idx, size_t size);
+void memstat_pool_alloc(void *ptr, size_t req, size_t size, uint32_t pc);
+void memstat_pool_free(void *ptr, size_t size);
+void memstat_fail(uint32_t pc);
+
+#define memstat_caller()	((uint32_t)__builtin_return_address(0))
+
+#else
+
+#define memstat_init(c)				0
+#define memstat_chunk_alloc(i, c, r, s, pc)	do { } while (0)
+#define memstat_chunk_free(i, s)		do { } while (0)
+#define memstat_pool_alloc(p, r, s, pc)		do { } while (0)
+#define memstat_pool_free(p, s)			do { } while (0)
+#define memstat_fail(pc)			do { } while (0)
+#define memstat_caller()			0
+
+#endif // CONFIG_MEMSTAT
+
+#endif // !_SYS_MEMSTAT_H
@@ -41,6 +41,10 @@ enum proc_state {
 	PROC_KILLED,				// Has been killed
 };
 
+#define PROC_HEAP_GRANTS	8		// Regions per process heap
+#define PROC_HEAP_MAX		0x00080000	// Bytes per process heap
+#define PROC_HEAP_ALIGN		4096		// Granularity of a region
+
 enum proc_mode {
 	PROC_USER = 0,				// Normal user-space
 	PROC_SYSTEM,				// Kernel/priviledged task
@@ -82,9 +86,18 @@ struct proc {
 	} timer;
 
 	struct self *self;
+
+	void		*heap[PROC_HEAP_GRANTS];// Regions granted to the
+	size_t		heap_size;		// user heap, see lib/heap.c
+
+	void		*arena;			// Private address space and its
+	int		domain;			// domain, see kernel/vm.c
 };
 
 // kernel/sched.c
 struct proc * spawn(void (*entry)(void), const char *name, enum proc_mode mode);
+void proc_kill(struct proc *p);
+int proc_event_raise(uint32_t mask, struct proc *skip);
+void * proc_heap_grant(struct proc *p, size_t size);
 
 #endif // !_SYS_PROC_H
@@ -28,98 +28,55 @@
  */
 
 /*
- * lib/math.c
+ * include/sys/prof.h
  *
- * For instruction emulation.
+ * Statistical sampling profiler.  On every Nth timer tick the PC that the
+ * timer interrupt preempted is sampled and counted against the current
+ * process, giving a per-task PC histogram that can be symbolized on the
+ * host against ertos.map.
+ *
+ * Profiling is enabled with CONFIG_PROF in components.
  */
 
-/* Borrowed from GCC. */
-
-unsigned long
-udivmodsi4(unsigned long num, unsigned long den, int modwanted)
-{
-  unsigned long bit = 1;
-  unsigned long res = 0;
-
-  while (den < num && bit && !(den & (1L<<31)))
-    {
-      den <<=1;
-      bit <<=1;
-    }
-  while (bit)
-    {
-      if (num >= den)
-        {
-          num -= den;
-          res |= bit;
-        }
-      bit >>=1;
-      den >>=1;
-    }
-  if (modwanted) return num;
-  return res;
-}
-
-/* Instruction emulation. */
-long
-__udivsi3 (long a, long b)
-{
-  return udivmodsi4 (a, b, 0);
-}
-
-/* Instruction emulation. */
-long
-__umodsi3 (long a, long b)
-{
-  return udivmodsi4 (a, b, 1);
-}
+#ifndef _SYS_PROF_H
+#define _SYS_PROF_H
 
+#include "../../config.h"
 
-long
-__divsi3 (long a, long b)
-{
-  int neg = 0;
-  long res;
+#include <types.h>
 
-  if (a < 0)
-    {
-      a = -a;
-      neg = !neg;
-    }
+// Must be a power of two
+#define PROF_BUCKETS	1024
 
-  if (b < 0)
-    {
-      b = -b;
-      neg = !neg;
-    }
+// Buckets looked at for a sample before it is dropped, which bounds the
+// time spent in the timer interrupt once the table fills up
+#define PROF_PROBES	16
 
-  res = udivmodsi4 (a, b, 0);
+// Low PC bits discarded when bucketing samples, 0 keeps exact PCs
+#define PROF_PC_SHIFT	0
 
-  if (neg)
-    res = -res;
+struct prof_bucket {
+	uint32_t pc;
+	uint16_t pid;
+	uint16_t count;
+};
 
-  return res;
-}
+#ifdef CONFIG_PROF
 
-long
-__modsi3 (long a, long b)
-{
-  int neg = 0;
-  long res;
+// kernel/prof.c
+extern struct prof_bucket prof_buckets[PROF_BUCKETS];
+extern uint32_t prof_samples;
+extern uint32_t prof_dropped;
 
-  if (a < 0)
-    {
-      a = -a;
-      neg = 1;
-    }
+void prof_start(int interval);
+void prof_stop(void);
+void prof_reset(void);
+void prof_tick(void);
 
-  if (b < 0)
-    b = -b;
+#else
 
-  res = udivmodsi4 (a, b, 1);
+#define prof_tick()	do { } while (0)
 
-  if (neg)
-    res = -res;
+#endif // CONFIG_PROF
 
-  return res;
-}
+#endif // !_SYS_PROF_H
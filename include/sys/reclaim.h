@@ -0,0 +1,66 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2022, Eric Enright
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * include/sys/reclaim.h
+ *
+ * Memory pressure notification and reclaim hooks.
+ */
+
+#ifndef _RECLAIM_H
+#define _RECLAIM_H
+
+#include <types.h>
+
+// A subsystem holding memory it can give back.  shrink() releases what it
+// can and returns the number of objects freed.  urgent is non-zero when an
+// allocation is about to fail, in which case everything that is merely
+// cached should go; otherwise only idle or stale objects should.
+//
+// Shrinkers run with IRQs masked, possibly from interrupt context.  They
+// must not sleep or allocate, only free.
+struct shrinker {
+	const char	*name;
+	int		(*shrink)(int urgent);
+	struct shrinker	*next;
+};
+
+int register_shrinker(struct shrinker *s);
+
+// Run every shrinker, returns the number of objects freed
+int mem_reclaim(int urgent);
+
+// Called by the allocator when a class or the pool drops below its
+// low-water mark.  Reclaim runs from the next timer tick.
+void mem_pressure(void);
+
+// Timer tick hook, runs pending reclaim and notifies waiting tasks
+void mem_reclaim_tick(void);
+
+#endif // !_RECLAIM_H
@@ -0,0 +1,72 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2022, Eric Enright
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _SLAB_H
+#define _SLAB_H
+
+#include <types.h>
+
+// Slabs are carved out of malloc() chunks of this size
+#define KMEM_SLAB_SHIFT	12
+#define KMEM_SLAB_SIZE	(1 << KMEM_SLAB_SHIFT)
+
+// ARM920T cache line, for objects touched by hot paths or DMA
+#define KMEM_CACHE_ALIGN	32
+
+struct kstat_slab;
+struct kmem_obj;
+struct kmem_slab;
+
+// An object cache.  Objects are handed out at their exact (aligned) size.
+// If a constructor is given it runs once when an object is first carved
+// from a new slab, and objects must be returned to the cache in their
+// constructed state.
+struct kmem_cache {
+	const char	*name;
+	size_t		size;		// Object size including padding
+	size_t		align;
+	void		(*ctor)(void *);
+	int		per_slab;	// Objects carved from each slab
+	int		free;		// Objects on the free list
+
+	struct kmem_obj	*free_list;
+	struct kmem_slab *slabs;
+	struct kstat_slab *stat;
+	struct kmem_cache *next;	// All caches, for statistics
+};
+
+struct kmem_cache * kmem_cache_create(const char *name, size_t size,
+	size_t align, void (*ctor)(void *));
+void * kmem_cache_alloc(struct kmem_cache *cache);
+void kmem_cache_free(struct kmem_cache *cache, void *obj);
+int kmem_cache_alloc_bulk(struct kmem_cache *cache, void **objs, int n);
+void kmem_cache_free_bulk(struct kmem_cache *cache, void **objs, int n);
+int kmem_cache_shrink(struct kmem_cache *cache, int urgent);
+
+#endif // !_SLAB_H
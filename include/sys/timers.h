@@ -38,10 +38,39 @@
 #define _SYS_TIMERS_H
 
 #include <types.h>
+#include <div.h>
 #include <sys/proc.h>
 
+#include "../../arch/regs.h"
+
+// The EP93xx 40-bit debug timer (Timer4) is free running from a 983.04kHz
+// clock, giving roughly microsecond resolution.  Only the low 32 bits are
+// read here, which wrap about every 73 minutes.
+#define DEBUG_TIMER_HZ		983040
+
 extern uint32_t clkticks;
 
+static inline uint32_t debug_timer_read(void)
+{
+	return inl(Timer4ValueLow);
+}
+
+// Convert debug timer ticks to microseconds
+static inline uint32_t debug_timer_to_us(uint32_t ticks)
+{
+	// 983040 ticks per second; 1017/1000 is within 0.03%
+	uint32_t k = udiv1000(ticks);
+
+	return k * 1017 + udiv1000((ticks - k * 1000) * 1017);
+}
+
+// Restart the debug timer from zero
+static inline void debug_timer_start(void)
+{
+	outl(Timer4ValueHigh, 0);
+	outl(Timer4ValueHigh, Timer4Enable);
+}
+
 void timer_int(void);
 void handle_task_timer_done(struct proc *p);
 void handle_task_timer(struct proc *p);
@@ -0,0 +1,113 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2022, Eric Enright
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * include/sys/trace.h
+ *
+ * Kernel event tracing.  Context switches, interrupts, system calls and
+ * wakeups are recorded into a ring buffer along with a timestamp from the
+ * debug timer.  The ring may then be dumped on the console or exported for
+ * host-side analysis.
+ *
+ * Tracing is enabled with CONFIG_TRACE in components; without it every
+ * trace point compiles away to nothing.
+ */
+
+#ifndef _SYS_TRACE_H
+#define _SYS_TRACE_H
+
+#include "../../config.h"
+
+#include <types.h>
+#include <sys/sched.h>
+#include <sys/timers.h>
+
+// Must be a power of two
+#define TRACE_ENTRIES	1024
+
+#define TRACE_VERSION	1
+
+enum trace_type {
+	TRACE_NONE = 0,
+	TRACE_SWITCH,		// arg: pid switched to
+	TRACE_IRQ_ENTRY,	// arg: irq number
+	TRACE_IRQ_EXIT,		// arg: irq number
+	TRACE_SYSCALL_ENTRY,	// arg: syscall number
+	TRACE_SYSCALL_EXIT,	// arg: return value
+	TRACE_WAKEUP,		// arg: pid woken up
+};
+
+// One trace record, 12 bytes.  The export format is these records as they
+// sit in memory, little-endian.
+struct trace_rec {
+	uint32_t ts;		// Debug timer, low 32 bits
+	uint16_t type;		// enum trace_type
+	uint16_t pid;		// Current process
+	uint32_t arg;
+};
+
+#ifdef CONFIG_TRACE
+
+// kernel/trace.c
+extern struct trace_rec trace_ring[TRACE_ENTRIES];
+extern volatile uint32_t trace_head;
+extern int trace_enabled;
+
+void trace_start(void);
+void trace_stop(void);
+void trace_clear(void);
+int trace_read(struct trace_rec *buf, int max, uint32_t *pos);
+
+// Record an event.  Callers run with interrupts masked (IRQ, SVC or the
+// scheduler), so there is only ever a single writer and claiming a slot is
+// just an increment of the head.  Readers never block the writer; see
+// trace_read().
+static inline void trace_event(int type, uint32_t arg)
+{
+	struct trace_rec *rec;
+
+	if (!trace_enabled)
+		return;
+
+	rec = &trace_ring[trace_head & (TRACE_ENTRIES - 1)];
+	rec->ts = debug_timer_read();
+	rec->type = type;
+	rec->pid = cur != NULL ? cur->pid : 0;
+	rec->arg = arg;
+
+	++trace_head;
+}
+
+#else
+
+#define trace_event(type, arg)	do { } while (0)
+
+#endif // CONFIG_TRACE
+
+#endif // !_SYS_TRACE_H
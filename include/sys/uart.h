@@ -33,9 +33,17 @@
 #include <types.h>
 #include <sleep.h>
 
+// Must be a power of two, so that indices can be masked
 #define UART_FIFO_SIZE	1024
+#define UART_FIFO_MASK	(UART_FIFO_SIZE - 1)
+
+#if UART_FIFO_SIZE & UART_FIFO_MASK
+#	error UART_FIFO_SIZE must be a power of two
+#endif
 
 struct uart;
+struct kstat_uart;
+struct kstat_uart_fifo;
 
 struct uart_ops {
 	int (*open)(struct uart *);		// Open UART
@@ -49,12 +57,23 @@ struct uart_ops {
 	void (*tx)(struct uart *);		// Transmit handler
 };
 
+/*
+ * Single producer, single consumer ring: the interrupt handler fills the
+ * receive FIFO and drains the transmit FIFO, and one task at a time does
+ * the other end of each.  head is only written by the consumer and tail
+ * by the producer, so neither side has to mask interrupts.  Both run
+ * freely and are masked on use; tail - head is the number of bytes held,
+ * which lets the FIFO fill completely.
+ */
 struct uart_fifo {
 	char data[UART_FIFO_SIZE];
-	int head;
-	int tail;
+	volatile uint32_t head;		// Next byte to remove
+	volatile uint32_t tail;		// Next byte to add
 };
 
+// Keep the compiler from moving data accesses across an index update
+#define uart_fifo_barrier()	__asm__ __volatile__("" : : : "memory")
+
 enum uart_state {
 	UART_OPEN = 0,
 	UART_CLOSED,
@@ -63,6 +82,10 @@ enum uart_state {
 struct uart {
 	struct uart_ops *uart_ops;	// Device I/O operations
 
+	int unit;			// Which port, from 0
+	uint32_t base;			// Registers, set by open
+	int irq;			// Interrupt, set by open
+
 	int baud;			// Current BAUD rate
 
 	struct uart_fifo rx_fifo;	// Receive FIFO
@@ -70,30 +93,27 @@ struct uart {
 
 	enum uart_state state;		// Current state
 
-	struct completion wait;		// Wait queue
+	struct completion wait;		// Wait queue, for received data
+	struct completion tx_wait;	// Wait queue, for room to transmit
+
+	struct kstat_uart *stat;	// Statistics, in kstat
+	struct kstat_uart_fifo *fifo_stat;	// FIFO statistics, in kstat
 };
 
-// Returns the number of bytes free in the FIFO
-static inline int uart_fifo_free(struct uart_fifo *f)
+// Returns the number of bytes contained in the FIFO
+static inline int uart_fifo_available(struct uart_fifo *f)
 {
-	if (f->tail > f->head)
-		return f->tail - f->head;
-
-	// Handle wraparound
-	return sizeof(f->data) - (f->head - f->tail);
+	return f->tail - f->head;
 }
 
-// Returns the number of bytes containted in the FIFO
-static inline int uart_fifo_available(struct uart_fifo *f)
+// Returns the number of bytes free in the FIFO
+static inline int uart_fifo_free(struct uart_fifo *f)
 {
-	if (f->tail >= f->head)
-		return f->tail - f->head;
-
-	// Handle wraparound
-	return sizeof(f->data) - (f->head - f->tail);
+	return UART_FIFO_SIZE - uart_fifo_available(f);
 }
 
 int uart_read(struct uart *, void *buf, size_t len);		// Read data
+int uart_set_baud(struct uart *, int baud);			// Set BAUD rate
 int uart_write(struct uart *, const void *buf, size_t len);	// Write data
 
 #endif // !_DEV_UART_H
@@ -0,0 +1,58 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2022, Eric Enright
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * include/sys/vm.h
+ *
+ * Per-task address spaces.
+ */
+
+#ifndef _VM_H
+#define _VM_H
+
+#include <types.h>
+
+struct proc;
+
+// Each user task gets a 1MB arena of its own, in a domain of its own.  The
+// heap grows up from the bottom of the arena and the stack sits at the
+// top; only pages actually handed out are mapped, so everything else in
+// the arena, including the gap below the stack, faults.
+#define VM_ARENA_SHIFT	20
+#define VM_ARENA_SIZE	(1 << VM_ARENA_SHIFT)
+#define VM_ARENAS	15		// Domains not used by the kernel
+#define VM_RAM_END	0x02000000	// End of RAM mapped by startup.S
+
+void vm_init(void);
+void * vm_arena_alloc(struct proc *p, size_t stack);
+void * vm_arena_grow(struct proc *p, size_t size);
+void vm_arena_free(struct proc *p);
+void vm_switch(struct proc *p);
+
+#endif // !_VM_H
@@ -41,11 +41,21 @@
 #define SYS_ALARM		6
 #define SYS_UTT_DONE		7
 #define SYS_RESET		8
-#define SYS_KSTAT		9
-#define SYS_NETSTAT		10
+// 9 and 10 were SYS_KSTAT and SYS_NETSTAT, see kstat_get() and netstat_get()
+#define SYS_HEAP_GROW		11
+#define SYS_EXIT		12
+#define SYS_CONS_WRITE		13
+#define SYS_CONS_READ		14
+#define SYS_TRACE_CLEAR		15
+#define SYS_PROF_RESET		16
+#define SYS_IRQSTAT_RESET	17
+#define SYS_ARP_SNAPSHOT	18
+#define SYS_SPAWN		19
 
 // syscall_arm.s
 #define _syscall(num) __syscall(num, 0)
 int __syscall(int num, uint32_t arg1);
+int __syscall2(int num, uint32_t arg1, uint32_t arg2);
+int __syscall3(int num, uint32_t arg1, uint32_t arg2, uint32_t arg3);
 
 #endif // !_SYSCALL_H
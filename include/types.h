@@ -30,6 +30,10 @@
 #ifndef _TYPES_H
 #define _TYPES_H
 
+typedef unsigned long long uint64_t;
+typedef uint64_t	u64;
+typedef long long	int64_t;
+typedef int64_t		s64;
 typedef unsigned int	uint32_t;
 typedef uint32_t	u32;
 typedef int		int32_t;
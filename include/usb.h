@@ -374,6 +374,7 @@ extern char *usb_pid_str[];
 extern char *usb_class_str[];
 extern int usb_class_str_max;
 
+int usb_init(void);
 void usb_attach_device(struct usb_hcd *hcd);
 
 #endif // !_USB_H
@@ -32,12 +32,19 @@
  *
  * Basic console driver using a serial port.
  *
- * @@@ these should be system calls
+ * Tasks go through the SYS_CONS_WRITE and SYS_CONS_READ system calls, so
+ * that a writer can sleep while the UART drains instead of spinning.  The
+ * kernel itself (interrupt handlers, system calls and boot, when self is
+ * kernel_self) cannot sleep, and polls the UART directly as before.
  */
 
 #include <sys/uart.h>
+#include <sys/cons.h>
+#include <sys/kernel.h>
+#include <sys/sched.h>
 #include <sleep.h>
 #include <string.h>
+#include <syscall.h>
 
 static struct uart *cons_uart = NULL;
 struct completion *cons_in_completion;
@@ -48,13 +55,43 @@ void cons_init(struct uart *uart)
 	cons_in_completion = &uart->wait;
 }
 
+// Queue as much of buf as fits.  If that was not all of it, put the caller
+// to sleep until the transmit interrupt has made room; it will come back
+// for the rest.
+int cons_tx(const void *buf, size_t len)
+{
+	int n;
+
+	if (cons_uart == NULL)
+		return -1;
+
+	n = uart_write(cons_uart, buf, len);
+	if (n < len && !bfifo_queue(cons_uart->tx_wait.wait, cur)) {
+		cur->state = PROC_SLEEP;
+		request_schedule();
+	}
+
+	return n;
+}
+
+int cons_rx(void *buf, size_t len)
+{
+	if (cons_uart == NULL)
+		return -1;
+
+	return uart_read(cons_uart, buf, len);
+}
+
 int cons_read(void *buf, size_t len)
 {
 	// If we have no console, return error
 	if (cons_uart == NULL)
 		return -1;
 
-	return uart_read(cons_uart, buf, len);
+	if (self == kernel_self)
+		return uart_read(cons_uart, buf, len);
+
+	return __syscall2(SYS_CONS_READ, (uint32_t)buf, len);
 }
 
 int cons_write(const void *buf, size_t len)
@@ -67,7 +104,11 @@ int cons_write(const void *buf, size_t len)
 		return -1;
 
 	do {
-		rc = uart_write(cons_uart, buf + n, len - n);
+		if (self == kernel_self)
+			rc = uart_write(cons_uart, buf + n, len - n);
+		else
+			rc = __syscall2(SYS_CONS_WRITE, (uint32_t)buf + n,
+				len - n);
 		n += rc;
 	} while (n < len && rc >= 0);
 
@@ -27,20 +27,167 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include "../config.h"
+
 #include <types.h>
 #include <sys/sched.h>
 #include <sys/kernel.h>
+#include <sys/timers.h>
+#include <sys/trace.h>
+#include <sys/irq.h>
 #include <kstat.h>
+#include <syscall.h>
+#include <string.h>
 
 #include "../arch/regs.h"
 
+#define IRQ_VECTORS	16	// Vectored interrupt slots per VIC
+
+// The VIC vector address registers are loaded with pointers to these rather
+// than the handlers themselves, so c_irq() knows which interrupt it is
+// servicing without having to look it up.
+struct irq_vector {
+	void (*handler)(void);
+	int irq;
+	uint32_t (*latency)(void);	// Optional, see irq_set_latency_probe()
+	struct irqstat_vec *stat;
+};
+
+static struct irq_vector irq_vectors[2][IRQ_VECTORS];
+
+#ifdef CONFIG_IRQSTAT
+static int irqoff_active = 0;
+static uint32_t irqoff_start;
+
+// Histogram bucket for a duration: bucket n counts [2^(n-1), 2^n) us
+static inline int irqstat_bucket(uint32_t t)
+{
+	int b = 0;
+
+	while (t != 0 && b < IRQSTAT_BUCKETS - 1) {
+		t >>= 1;
+		++b;
+	}
+
+	return b;
+}
+
+// The debug timer runs at 983.04kHz, close enough to 1us per tick
+static void irqstat_account(struct irq_vector *vec, uint32_t lat, uint32_t t)
+{
+	struct irqstat_vec *st = vec->stat;
+
+	kstat_write_begin();
+
+	++st->count;
+
+	++st->time_hist[irqstat_bucket(t)];
+	if (t > st->time_max)
+		st->time_max = t;
+
+	if (vec->latency != NULL) {
+		++st->lat_hist[irqstat_bucket(lat)];
+		if (lat > st->lat_max)
+			st->lat_max = lat;
+	}
+
+	kstat_write_end();
+}
+
+// Called from cli() with the CPSR as it was before IRQs were masked.  In
+// user mode cli() and sti() can not touch the I bit, so there is nothing
+// to time.
+void irqoff_begin(uint32_t cpsr)
+{
+	if ((cpsr & ARM_MODE_MASK) == ARM_MODE_USR || (cpsr & ARM_NO_IRQ))
+		return;
+
+	irqoff_start = debug_timer_read();
+	irqoff_active = 1;
+}
+
+// Called from sti() before IRQs are unmasked; pc is the caller of sti()
+void irqoff_end(uint32_t cpsr, uint32_t pc)
+{
+	uint32_t t;
+
+	if ((cpsr & ARM_MODE_MASK) == ARM_MODE_USR || !(cpsr & ARM_NO_IRQ)
+		|| !irqoff_active)
+		return;
+
+	irqoff_active = 0;
+
+	t = debug_timer_read() - irqoff_start;
+	if (t > kstat.irq.irqoff_max) {
+		kstat_write_begin();
+		kstat.irq.irqoff_max = t;
+		kstat.irq.irqoff_pc = pc;
+		kstat_write_end();
+	}
+}
+
+// System calls run with IRQs masked from start to finish
+void irqstat_svc(uint32_t num, uint32_t t)
+{
+	if (t > kstat.irq.svc_max) {
+		kstat_write_begin();
+		kstat.irq.svc_max = t;
+		kstat.irq.svc_num = num;
+		kstat_write_end();
+	}
+}
+
+// c_irq() updates the statistics with IRQs masked, so tasks reset them
+// through SYS_IRQSTAT_RESET
+void irqstat_reset(void)
+{
+	uint32_t flags;
+	int i;
+
+	if (self != kernel_self) {
+		_syscall(SYS_IRQSTAT_RESET);
+		return;
+	}
+
+	flags = irq_save();
+	kstat_write_begin();
+
+	for (i = 0; i < IRQSTAT_VECTORS; ++i) {
+		kstat.irq.vec[i].count = 0;
+		kstat.irq.vec[i].time_max = 0;
+		kstat.irq.vec[i].lat_max = 0;
+		memset(kstat.irq.vec[i].time_hist, 0,
+			sizeof(kstat.irq.vec[i].time_hist));
+		memset(kstat.irq.vec[i].lat_hist, 0,
+			sizeof(kstat.irq.vec[i].lat_hist));
+	}
+
+	kstat.irq.irqoff_max = 0;
+	kstat.irq.irqoff_pc = 0;
+	kstat.irq.svc_max = 0;
+	kstat.irq.svc_num = 0;
+
+	kstat_write_end();
+	irq_restore(flags);
+}
+#endif // CONFIG_IRQSTAT
+
+// The PC interrupted by the IRQ currently being serviced
+uint32_t irq_pc;
+
 void arm_irq_entry(void);
 
-void c_irq(void)
+// frame points at the registers saved by arm_irq_entry: r0-r3, r12 and the
+// corrected return address
+void c_irq(uint32_t *frame)
 {
-	void (*handler)(void);
+	struct irq_vector *vec;
+#ifdef CONFIG_IRQSTAT
+	uint32_t start, lat = 0;
+#endif
 
 	self = kernel_self;
+	irq_pc = frame[5];
 
 /*
 	// Notify VIC1 that we are processing the interrupt
@@ -57,14 +204,25 @@ void c_irq(void)
 */
 
 	// Notify VIC2 that we are processing the interrupt
-	handler = (void *)inl(VIC2VectAddr);
+	vec = (struct irq_vector *)inl(VIC2VectAddr);
 
 	// Service the interrupt
 	// Avoid recursion into arm_irq_entry, @@@ why is it showing up??
-	if (handler == arm_irq_entry)
+	if (vec == (struct irq_vector *)arm_irq_entry) {
 		++kstat.isr_recursion;
-	else if (handler != NULL)
-		handler();
+	} else if (vec != NULL) {
+		trace_event(TRACE_IRQ_ENTRY, vec->irq);
+#ifdef CONFIG_IRQSTAT
+		if (vec->latency != NULL)
+			lat = vec->latency();
+		start = debug_timer_read();
+#endif
+		vec->handler();
+#ifdef CONFIG_IRQSTAT
+		irqstat_account(vec, lat, debug_timer_read() - start);
+#endif
+		trace_event(TRACE_IRQ_EXIT, vec->irq);
+	}
 
 	// Notify VIC2 that we have processed the interrupt
 	outl(VIC2VectAddr, 0);
@@ -77,35 +235,41 @@ int register_irq_handler(int irq, void *handler, int fast)
 	uint32_t *addr;
 	uint32_t *ctrl;
 	uint32_t *sel;
+	struct irq_vector *vec;
 	int i = 0;
 
-
 	if (irq < 32) {
 		addr = (uint32_t *)VIC1VectAddr0;
 		ctrl = (uint32_t *)VIC1VectCntl0;
 		sel  = (uint32_t *)VIC1IntSelect;
+		vec  = irq_vectors[0];
 	} else if (irq < 64) {
-		irq -= 32;
 		addr = (uint32_t *)VIC2VectAddr0;
 		ctrl = (uint32_t *)VIC2VectCntl0;
 		sel  = (uint32_t *)VIC2IntSelect;
+		vec  = irq_vectors[1];
 	} else {
 		return -1;
 	}
 
 	i = inl(sel);
 	if (fast)
-		i |= (1 << irq);
+		i |= (1 << (irq & 31));
 	else
-		i &= ~(1 << irq);
+		i &= ~(1 << (irq & 31));
 	outl(sel, i);
 
 	// Look for an open vector
-	for (i = 0; i < 16; ++i) {
-		if ((uint32_t *)inl(addr + (i * 4)) == NULL) {
+	for (i = 0; i < IRQ_VECTORS; ++i) {
+		if ((uint32_t *)inl(addr + i) == NULL) {
 			// Found one
-			outl(addr + (i * 4), handler);
-			outl(ctrl + (i * 4), irq | INT_ENABLE);
+			vec[i].handler = handler;
+			vec[i].irq = irq;
+			vec[i].stat = &kstat.irq.vec[(vec - irq_vectors[0]) + i];
+			vec[i].stat->irq = irq;
+
+			outl(addr + i, &vec[i]);
+			outl(ctrl + i, (irq & 31) | INT_ENABLE);
 			return 0;
 		}
 	}
@@ -114,3 +278,20 @@ int register_irq_handler(int irq, void *handler, int fast)
 	return -1;
 }
 
+// Register a function which returns how long, in microseconds, the given
+// interrupt has been asserted.  Only sources which can tell (such as a timer
+// which keeps counting after it fires) have one.
+int irq_set_latency_probe(int irq, uint32_t (*probe)(void))
+{
+	struct irq_vector *vec = irq_vectors[0];
+	int i;
+
+	for (i = 0; i < 2 * IRQ_VECTORS; ++i) {
+		if (vec[i].handler != NULL && vec[i].irq == irq) {
+			vec[i].latency = probe;
+			return 0;
+		}
+	}
+
+	return -1;
+}
@@ -38,6 +38,8 @@
 #include <sys/irq.h>
 #include <sys/sched.h>
 #include <sys/kernel.h>
+#include <sys/timers.h>
+#include <sys/vm.h>
 
 #include <stdio.h>
 #include <kstat.h>
@@ -90,28 +92,32 @@ struct self _kernel_self = {
 
 struct self *kernel_self = &_kernel_self;
 
-struct mem_desc {
-	int	least_remaining;// Least number of remaining chunks ever seen
-	int	size;		// Chunk size
-	struct bfifo *allocations;	// Allocated memory regions
-};
-
-extern struct mem_desc *mem_desc[];
-
 // kernel/sched.c
 void idle(void);
 
 // Main kernel entry point. Perform initialization here.
 void main(void)
 {
+	int i;
+
 	// Interrupts are disabled upon entry
 
+	// Boot is timed from here, see kstat.boot
+	debug_timer_start();
+
+	// Before anything registers an IRQ and starts filling in statistics
+	memset(&kstat, 0, sizeof(kstat));
+	kstat.version = KSTAT_VERSION;
+	kstat.size = sizeof(kstat);
+	for (i = 0; i < IRQSTAT_VECTORS; ++i)
+		kstat.irq.vec[i].irq = IRQSTAT_UNUSED;
+
 	mem_init();	// Must come first in case arch and sched need malloc
+	kstat.boot.mem_init = debug_timer_read();
+	vm_init();	// Takes the RAM left over by mem_init
 	arch_init();
 	sched_init();
 
-	memset(&kstat, 0, sizeof(kstat));
-
 	// OK, everything should be good to go so bring up the interrupts
 	sti();
 
@@ -122,8 +128,9 @@ void main(void)
 	printf("Kernel self is 0x%x\r\n", kernel_self);
 
 #ifdef CONFIG_NET
-	ep9301_eth_init();
+	// The stack must be up before the driver can hand it packets
 	eth_init();
+	ep9301_eth_init();
 #endif
 
 	run_boot_processes();
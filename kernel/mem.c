@@ -36,31 +36,72 @@
 
 #include <sys/mem.h>
 #include <sys/sched.h>
-#include <sys/list.h>
+#include <sys/irq.h>
+#include <sys/tlsf.h>
+#include <sys/memstat.h>
+#include <sys/reclaim.h>
+#include <sys/cache.h>
 
 #include <stdio.h>
+#include <string.h>
+#include <kstat.h>
 
-#define ALLOC_MIN	32	// Smallest allocation chunk
-#define ALLOC_STEPS	9	// Number of allocation shifts, max chunk 8k
-#define ALLOC_NUM	128	// Number of chunks per allocation step
 #define SMALLOC_SIZE	0x00100000	// 1MB for smalloc
+#define POOL_SIZE	0x00200000	// 2MB TLSF pool for everything else
+
+// Default low-water marks, below which the shrinkers are run
+#define CLASS_LOW_WATER	8	// Free chunks in a class, 1 in this many
+#define POOL_LOW_WATER	(POOL_SIZE / 8)	// Free bytes in the pool
+
+// Chunk regions are page aligned so a page lookup identifies the class of
+// any pointer being freed
+#define MEM_PAGE_SHIFT	12
+#define MEM_PAGE_SIZE	(1 << MEM_PAGE_SHIFT)
+
+// Free chunks are kept on intrusive singly linked lists
+struct mem_chunk {
+	struct mem_chunk *next;
+};
 
 struct mem_desc {
 	int	least_free;	// Least number of remaining chunks ever seen
+	int	free;		// Chunks on the free list or not yet carved
 	int	size;		// Chunk size
+	int	num;		// Chunks in the class
+	int	first;		// Index of the first chunk across all classes
+	int	low_water;	// Free chunks below which memory is short
 	void	*start;		// Allocation region start
 	void	*end;		// Allocation region end
-	struct bfifo *allocations;	// Allocated memory regions
+	void	*bump;		// First chunk never handed out
+	struct mem_chunk *free_list;
 };
 
 // These come in from the linker
 extern void *__end__;
+extern char __dma_data__[], __dma_pool__[], __dma_end__[];
 
 void *_heap_start = NULL;
 size_t _heap_size = 0;
 static void *heap_cur = NULL;
+static void *dma_cur = __dma_pool__;
+
+static struct mem_desc mem_desc[ALLOC_STEPS];
+static const int alloc_counts[ALLOC_STEPS] = { ALLOC_COUNTS };
 
-struct mem_desc *mem_desc[ALLOC_STEPS];
+// Size class for each request size, indexed by (size - 1) / ALLOC_MIN.  The
+// ARM920T has no clz instruction, so a table is the cheapest O(1) mapping.
+static uint8_t size_class[ALLOC_MAX >> ALLOC_MIN_SHIFT];
+
+// Size class owning each page of the chunk regions
+static uint8_t *page_class = NULL;
+static void *chunk_start = NULL;	// First chunk region
+static void *chunk_end = NULL;		// End of the last chunk region
+
+// Variable sized pool for requests the classes can not serve
+static struct tlsf *pool = NULL;
+static void *pool_start = NULL;
+static void *pool_end = NULL;
+static size_t pool_low_water = POOL_LOW_WATER;
 
 int dmalloc_enabled = 0;	// true of "dynamic" malloc was initialized
 
@@ -79,35 +120,282 @@ void * smalloc(size_t size)
 		// Realign heap_cur
 		if ((uint32_t)heap_cur % 4)
 			heap_cur += 4 - ((uint32_t)heap_cur % 4);
+
+		kstat.mem.smalloc_used = heap_cur - _heap_start;
 	}
 		
 	return p;
 }
 
-void * malloc(size_t size)
+/*
+ * Permanently allocate from the uncached DMA region, for descriptors and
+ * buffers shared with devices.  align must be a power of two, or 0.
+ */
+void * dma_alloc(size_t size, size_t align)
 {
-	int i;
+	uint32_t flags;
 	void *p = NULL;
 
+	if (align < CACHE_LINE)
+		align = CACHE_LINE;
+
+	flags = irq_save();
+
+	p = (void *)(((uint32_t)dma_cur + align - 1) & ~(align - 1));
+	if (p + size <= (void *)__dma_end__ && p + size >= p)
+		dma_cur = p + size;
+	else
+		p = NULL;
+
+	irq_restore(flags);
+
+	return p;
+}
+
+// Account for a pool allocation, called with IRQs masked
+static void pool_account(void *p, size_t old)
+{
+	if (p != NULL)
+		kstat.pool.used += tlsf_block_size(p);
+	kstat.pool.used -= old;
+
+	if (kstat.pool.used > kstat.pool.peak)
+		kstat.pool.peak = kstat.pool.used;
+}
+
+static void * pool_alloc(size_t align, size_t size, uint32_t pc)
+{
+	uint32_t flags;
+	void *p;
+
+	flags = irq_save();
+
+	p = tlsf_memalign(pool, align, size);
+	if (p != NULL) {
+		pool_account(p, 0);
+		memstat_pool_alloc(p, size, tlsf_block_size(p), pc);
+
+		if (kstat.pool.size - kstat.pool.used < pool_low_water)
+			mem_pressure();
+	}
+
+	irq_restore(flags);
+
+	return p;
+}
+
+#define is_pool_ptr(p)	((void *)(p) >= pool_start && (void *)(p) < pool_end)
+#define is_chunk_ptr(p)	((void *)(p) >= chunk_start && (void *)(p) < chunk_end)
+
+// Index of a chunk across all classes, for per-chunk side tables
+#define chunk_index(i, p) \
+	(mem_desc[i].first + (((void *)(p) - mem_desc[i].start) >> (ALLOC_MIN_SHIFT + (i))))
+
+// Take the first chunk of class i, falling back to larger classes once it
+// runs dry.  Returns NULL if all are exhausted.  Freed chunks are reused
+// before the class region is carved any further.
+static void * class_alloc(int i, size_t size, uint32_t pc)
+{
+	struct mem_desc *d;
+	struct mem_chunk *c = NULL;
+	uint32_t flags;
+
+	flags = irq_save();
+
+	for (; i < ALLOC_STEPS; ++i) {
+		d = &mem_desc[i];
+
+		c = d->free_list;
+		if (c != NULL) {
+			d->free_list = c->next;
+		} else if (d->bump < d->end) {
+			c = d->bump;
+			d->bump += d->size;
+		}
+
+		if (c != NULL) {
+			if (--d->free < d->least_free)
+				d->least_free = d->free;
+
+			if (++kstat.mem.class[i].in_use > kstat.mem.class[i].peak)
+				kstat.mem.class[i].peak = kstat.mem.class[i].in_use;
+
+			memstat_chunk_alloc(chunk_index(i, c), i, size, d->size, pc);
+
+			if (d->free < d->low_water)
+				mem_pressure();
+			break;
+		}
+
+		++kstat.mem.class[i].exhausted;
+	}
+
+	irq_restore(flags);
+
+	return c;
+}
+
+/*
+ * Allocate from the classes starting at cls, or the one serving size if
+ * cls is -1, falling back to the pool.  If both are out of memory the
+ * shrinkers get one chance to free some before giving up.
+ */
+static void * do_alloc(size_t align, size_t size, int cls, uint32_t pc)
+{
+	uint32_t flags;
+	int retry = 1;
+	void *p;
+
+	if (size == 0)
+		size = 1;
+
+	if (cls < 0 && align <= MEM_PAGE_SIZE
+		&& (size < align ? align : size) <= ALLOC_MAX)
+		cls = size_class[((size < align ? align : size) - 1)
+			>> ALLOC_MIN_SHIFT];
+
+	do {
+		p = NULL;
+
+		if (cls >= 0)
+			p = class_alloc(cls, size, pc);
+
+		// Too large for a class, or every class large enough is
+		// exhausted
+		if (p == NULL)
+			p = pool_alloc(align, size, pc);
+	} while (p == NULL && retry-- && mem_reclaim(1) > 0);
+
+	if (p == NULL) {
+		flags = irq_save();
+		++kstat.mem.failures;
+		memstat_fail(pc);
+		irq_restore(flags);
+	}
+
+	return p;
+}
+
+static void * do_malloc(size_t size, uint32_t pc)
+{
 	// Fall back to simple malloc if required
 	if (!dmalloc_enabled)
 		return smalloc(size);
 
-	// Find a suitable memory descriptor
-	for (i = 0; i < ALLOC_STEPS; ++i) {
-		// Is this step large enough?
-		if (mem_desc[i]->size < size)
-			continue;	// No
+	return do_alloc(0, size, -1, pc);
+}
+
+void * (malloc)(size_t size)
+{
+	return do_malloc(size, memstat_caller());
+}
+
+// Allocate from class cls, chosen at compile time by the malloc() macro
+void * mem_alloc_class(int cls, size_t size)
+{
+	if (!dmalloc_enabled)
+		return smalloc(size);
+
+	return do_alloc(0, size, cls, memstat_caller());
+}
+
+/*
+ * Allocate size bytes aligned to align, which must be a power of two.
+ * Class regions are page aligned, so a chunk is aligned to its own size
+ * up to a page; anything stricter comes from the pool.
+ */
+void * memalign(size_t align, size_t size)
+{
+	if (!dmalloc_enabled)
+		return NULL;
+
+	return do_alloc(align, size, -1, memstat_caller());
+}
+
+/*
+ * Set the low-water mark of the class serving size to chunks free chunks,
+ * or of the pool to chunks free bytes if size is too large for a class.
+ * Dropping below it triggers reclaim and wakes tasks waiting on
+ * EVENT_MEM_PRESSURE.
+ */
+int mem_low_water(size_t size, int chunks)
+{
+	struct mem_desc *d;
+
+	if (size == 0 || chunks < 0)
+		return -1;
+
+	if (size > ALLOC_MAX) {
+		pool_low_water = chunks;
+		return 0;
+	}
+
+	d = &mem_desc[size_class[(size - 1) >> ALLOC_MIN_SHIFT]];
+	if (chunks > d->num)
+		return -1;
+
+	d->low_water = chunks;
 
-		// Yes. Is there room for us?
-		// @@@ need locking here!!
-		p = bfifo_dequeue(mem_desc[i]->allocations);
+	return 0;
+}
+
+/*
+ * Resize an allocation.  Chunks keep their class while the new size still
+ * fits; pool allocations grow in place when the following block is free.
+ */
+void * realloc(void *ptr, size_t size)
+{
+	uint32_t pc = memstat_caller();
+	uint32_t flags;
+	size_t old;
+	void *p;
+	int i;
+
+	if (ptr == NULL)
+		return do_malloc(size, pc);
+
+	if (size == 0) {
+		free(ptr);
+		return NULL;
+	}
+
+	if (is_pool_ptr(ptr)) {
+		flags = irq_save();
+
+		old = tlsf_block_size(ptr);
+		p = tlsf_realloc(pool, ptr, size);
 		if (p != NULL) {
-			// Yes
-			if (mem_desc[i]->allocations->free < mem_desc[i]->least_free)
-				mem_desc[i]->least_free = mem_desc[i]->allocations->free;
-			break;
+			pool_account(p, old);
+			memstat_pool_free(ptr, old);
+			memstat_pool_alloc(p, size, tlsf_block_size(p), pc);
+		} else {
+			++kstat.mem.failures;
+			memstat_fail(pc);
 		}
+
+		irq_restore(flags);
+
+		return p;
+	}
+
+	if (!is_chunk_ptr(ptr))
+		return NULL;
+
+	i = page_class[(ptr - chunk_start) >> MEM_PAGE_SHIFT];
+	old = mem_desc[i].size;
+	if (size <= old) {
+		flags = irq_save();
+		memstat_chunk_free(chunk_index(i, ptr), old);
+		memstat_chunk_alloc(chunk_index(i, ptr), i, size, old, pc);
+		irq_restore(flags);
+
+		return ptr;
+	}
+
+	p = do_malloc(size, pc);
+	if (p != NULL) {
+		memcpy(p, ptr, old);
+		free(ptr);
 	}
 
 	return p;
@@ -115,75 +403,138 @@ void * malloc(size_t size)
 
 void free(void *ptr)
 {
+	struct mem_desc *d;
+	struct mem_chunk *c = ptr;
+	uint32_t flags;
 	int i;
 
 	// Simple malloc can not free
 	if (!dmalloc_enabled)
 		return;
 
-	// Determine which descriptor this pointer fits within
-	for (i = 0; i < ALLOC_STEPS; ++i) {
-		if (ptr >= mem_desc[i]->start && ptr <= mem_desc[i]->end) {
-			bfifo_queue(mem_desc[i]->allocations, ptr);
-		}
+	if (is_pool_ptr(ptr)) {
+		flags = irq_save();
+
+		pool_account(NULL, tlsf_block_size(ptr));
+		memstat_pool_free(ptr, tlsf_block_size(ptr));
+		tlsf_free(pool, ptr);
+
+		irq_restore(flags);
+		return;
 	}
+
+	// Ignore anything which did not come from a chunk region
+	if (!is_chunk_ptr(ptr))
+		return;
+
+	i = page_class[(ptr - chunk_start) >> MEM_PAGE_SHIFT];
+	d = &mem_desc[i];
+
+	flags = irq_save();
+
+	c->next = d->free_list;
+	d->free_list = c;
+	++d->free;
+	--kstat.mem.class[i].in_use;
+	memstat_chunk_free(chunk_index(i, ptr), d->size);
+
+	irq_restore(flags);
 }
 
 void mem_init(void)
 {
+	struct mem_desc *d;
+	int pages = 0, chunks = 0;
 	int i, j;
-	void *p;
-	int fsize = sizeof(struct bfifo) + (sizeof(void *) * (ALLOC_NUM - 1));
 
-	_heap_size = SMALLOC_SIZE;
-	_heap_size += (fsize + sizeof(struct mem_desc)) * ALLOC_STEPS;
+	// Each class region is rounded up to whole pages
+	for (i = 0; i < ALLOC_STEPS; ++i) {
+		pages += ((ALLOC_MIN << i) * alloc_counts[i] + MEM_PAGE_SIZE - 1)
+			>> MEM_PAGE_SHIFT;
+		chunks += alloc_counts[i];
+	}
 
-	// Calculate heap size
-	for (i = 0; i < ALLOC_STEPS; ++i)
-		_heap_size += (ALLOC_MIN << i) * ALLOC_NUM;
+	_heap_size = SMALLOC_SIZE + pages + MEM_PAGE_SIZE;
+	_heap_size += pages << MEM_PAGE_SHIFT;
+	_heap_size += POOL_SIZE;
 
 	_heap_start = &__end__;
 	heap_cur = _heap_start;
 
-	// Initialize descriptors
-	for (i = 0; i < ALLOC_STEPS; ++i) {
-		mem_desc[i] = smalloc(sizeof(struct mem_desc));
-		if (mem_desc[i] == NULL) {
-			// @@@
-			return;
-		}
+	// Static DMA objects live outside .bss, so clear them here
+	memset(__dma_data__, 0, __dma_pool__ - __dma_data__);
+
+	kstat.mem.heap_size = _heap_size;
+
+	page_class = smalloc(pages);
+	if (page_class == NULL) {
+		// @@@
+		return;
+	}
 
-		mem_desc[i]->least_free = ALLOC_NUM;
-		mem_desc[i]->size = ALLOC_MIN << i;
+	if (memstat_init(chunks)) {
+		// @@@
+		return;
+	}
+
+	// Page align the chunk regions
+	if ((uint32_t)heap_cur % MEM_PAGE_SIZE)
+		smalloc(MEM_PAGE_SIZE - ((uint32_t)heap_cur % MEM_PAGE_SIZE));
 
-		mem_desc[i]->allocations = smalloc(fsize);
-		if (mem_desc[i]->allocations == NULL) {
+	chunk_start = heap_cur;
+
+	// Size class lookup table
+	for (i = 0, j = 0; i < sizeof(size_class); ++i) {
+		if ((i << ALLOC_MIN_SHIFT) >= (ALLOC_MIN << j))
+			++j;
+		size_class[i] = j;
+	}
+
+	// Reserve each class region.  Chunks are carved from it as they are
+	// first needed, so boot does not touch the regions at all.
+	for (i = 0, chunks = 0; i < ALLOC_STEPS; ++i) {
+		d = &mem_desc[i];
+
+		d->size = ALLOC_MIN << i;
+		d->num = alloc_counts[i];
+		d->first = chunks;
+		d->free = d->num;
+		d->least_free = d->num;
+		d->low_water = d->num / CLASS_LOW_WATER;
+		d->free_list = NULL;
+		chunks += d->num;
+
+		d->start = smalloc(((d->size * d->num + MEM_PAGE_SIZE - 1)
+			>> MEM_PAGE_SHIFT) << MEM_PAGE_SHIFT);
+		if (d->start == NULL) {
 			// @@@
 			return;
 		}
+		d->end = d->start + d->size * d->num;
+		d->bump = d->start;
 
-		memset(mem_desc[i]->allocations, 0, fsize);
-		mem_desc[i]->allocations->size = ALLOC_NUM;
-		mem_desc[i]->allocations->free = ALLOC_NUM;
-	}
+		memset(&page_class[(d->start - chunk_start) >> MEM_PAGE_SHIFT],
+			i, (heap_cur - d->start) >> MEM_PAGE_SHIFT);
 
-	// Initialize FIFOs
-	for (i = 0; i < ALLOC_STEPS; ++i) {
-		for (j = 0; j < ALLOC_NUM; ++j) {
-			p = smalloc(mem_desc[i]->size);
-			if (p == NULL) {
-				// @@@
-				return;
-			}
+		kstat.mem.class[i].size = d->size;
+		kstat.mem.class[i].total = d->num;
+	}
 
-			bfifo_queue(mem_desc[i]->allocations, p);
+	chunk_end = heap_cur;
 
-			if (j == 0)
-				mem_desc[i]->start = p;
-		}
+	pool_start = smalloc(POOL_SIZE);
+	if (pool_start == NULL) {
+		// @@@
+		return;
+	}
+	pool_end = pool_start + POOL_SIZE;
 
-		mem_desc[i]->end = p + mem_desc[i]->size;
+	pool = tlsf_create(pool_start, POOL_SIZE);
+	if (pool == NULL) {
+		// @@@
+		return;
 	}
+	kstat.pool.size = tlsf_pool_size(pool);
 
 	// Initialization successful
 	dmalloc_enabled = 1;
@@ -204,10 +555,5 @@ void user_page_fault(void *ptr)
 	printf("r12: %x sp: %x lr: %x\r\n",
 		cur->regs[14], cur->regs[15], cur->regs[16]);
 */
-	// @@@ this should be a function somewhere
-	cur->state = PROC_KILLED;
-	cur->timer.ticks_wakeup = 0xFFFFFFFF;
-	cur->event_mask = 0;
-
-	request_schedule();
+	proc_kill(cur);
 }
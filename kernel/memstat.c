@@ -0,0 +1,269 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2022, Eric Enright
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * kernel/memstat.c
+ *
+ * Allocator statistics.  Chunk allocations have a record per chunk, found
+ * by chunk index.  Pool allocations are few and large, so their records
+ * live in a small open addressed table keyed by pointer.
+ */
+
+#include <sys/memstat.h>
+#include <sys/mem.h>
+#include <sys/sched.h>
+
+#include <string.h>
+
+struct memstat_pool_rec {
+	void *ptr;			// NULL if the slot is empty
+	struct memstat_rec rec;
+};
+
+struct memstat memstat;
+
+static struct memstat_rec *chunk_recs = NULL;
+static struct memstat_pool_rec pool_recs[MEMSTAT_POOL];
+
+#define pool_hash(p)	(((uint32_t)(p) >> 3) & (MEMSTAT_POOL - 1))
+#define site_hash(pc)	(((pc) >> 2) & (MEMSTAT_SITES - 1))
+
+// Find the slot of a process, taking one if create is set
+static struct memstat_pid * find_pid(uint16_t pid, int create)
+{
+	struct memstat_pid *empty = NULL, *idle = NULL, *p;
+	int i;
+
+	for (i = 0; i < MEMSTAT_PIDS; ++i) {
+		p = &memstat.pid[i];
+
+		if (!p->used) {
+			if (empty == NULL)
+				empty = p;
+		} else if (p->pid == pid) {
+			return p;
+		} else if (p->live == 0 && idle == NULL) {
+			// Processes holding nothing give up their slot last
+			idle = p;
+		}
+	}
+
+	if (empty == NULL)
+		empty = idle;
+
+	if (!create || empty == NULL)
+		return &memstat.other;
+
+	memset(empty, 0, sizeof(struct memstat_pid));
+	empty->pid = pid;
+	empty->used = 1;
+
+	return empty;
+}
+
+static struct memstat_site * find_site(uint32_t pc)
+{
+	struct memstat_site *s;
+	int i, n;
+
+	i = site_hash(pc);
+	for (n = 0; n < MEMSTAT_SITES; ++n) {
+		s = &memstat.site[i];
+
+		if (s->pc == pc)
+			return s;
+
+		if (s->pc == 0) {
+			s->pc = pc;
+			return s;
+		}
+
+		i = (i + 1) & (MEMSTAT_SITES - 1);
+	}
+
+	++memstat.sites_dropped;
+
+	return NULL;
+}
+
+static inline uint16_t cur_pid(void)
+{
+	return cur != NULL ? cur->pid : 0;
+}
+
+static void account(struct memstat_rec *r, int cls, size_t req, size_t size,
+	uint32_t pc)
+{
+	struct memstat_pid *p;
+	struct memstat_site *s;
+
+	r->pc = pc;
+	r->req = req;
+	r->pid = cur_pid();
+	r->cls = cls;
+
+	if (cls == MEMSTAT_CLASS_POOL)
+		memstat.pool_requested += req;
+	else
+		memstat.requested[cls] += req;
+
+	p = find_pid(r->pid, 1);
+	p->live += size;
+	++p->allocs;
+	if (p->live > p->peak)
+		p->peak = p->live;
+
+	s = find_site(pc);
+	if (s != NULL) {
+		s->live += size;
+		++s->count;
+		++s->allocs;
+	}
+}
+
+static void release(struct memstat_rec *r, size_t size)
+{
+	struct memstat_pid *p;
+	struct memstat_site *s;
+
+	if (r->cls == MEMSTAT_CLASS_POOL)
+		memstat.pool_requested -= r->req;
+	else
+		memstat.requested[r->cls] -= r->req;
+
+	// The owner may have been pushed out of the table, in which case its
+	// bytes were counted against other
+	p = find_pid(r->pid, 0);
+	if (p->live >= size)
+		p->live -= size;
+
+	s = find_site(r->pc);
+	if (s != NULL && s->count > 0) {
+		s->live -= size;
+		--s->count;
+	}
+}
+
+// Returns non-zero on error
+int memstat_init(int chunks)
+{
+	memset(&memstat, 0, sizeof(memstat));
+	memset(pool_recs, 0, sizeof(pool_recs));
+
+	chunk_recs = smalloc(chunks * sizeof(struct memstat_rec));
+	if (chunk_recs == NULL)
+		return -1;
+
+	return 0;
+}
+
+void memstat_chunk_alloc(int idx, int cls, size_t req, size_t size,
+	uint32_t pc)
+{
+	account(&chunk_recs[idx], cls, req, size, pc);
+}
+
+void memstat_chunk_free(int idx, size_t size)
+{
+	release(&chunk_recs[idx], size);
+}
+
+void memstat_pool_alloc(void *ptr, size_t req, size_t size, uint32_t pc)
+{
+	struct memstat_pool_rec *r;
+	int i, n;
+
+	i = pool_hash(ptr);
+	for (n = 0; n < MEMSTAT_POOL; ++n) {
+		r = &pool_recs[i];
+
+		if (r->ptr == NULL) {
+			r->ptr = ptr;
+			account(&r->rec, MEMSTAT_CLASS_POOL, req, size, pc);
+			return;
+		}
+
+		i = (i + 1) & (MEMSTAT_POOL - 1);
+	}
+
+	++memstat.untracked;
+}
+
+void memstat_pool_free(void *ptr, size_t size)
+{
+	struct memstat_pool_rec *r;
+	int i, j, k, n;
+
+	i = pool_hash(ptr);
+	for (n = 0; n < MEMSTAT_POOL; ++n) {
+		r = &pool_recs[i];
+
+		if (r->ptr == ptr)
+			break;
+
+		// Not tracked
+		if (r->ptr == NULL)
+			return;
+
+		i = (i + 1) & (MEMSTAT_POOL - 1);
+	}
+
+	if (n == MEMSTAT_POOL)
+		return;
+
+	release(&r->rec, size);
+
+	// Shift later members of the probe sequence back into the hole so
+	// lookups never need tombstones
+	j = i;
+	while (1) {
+		j = (j + 1) & (MEMSTAT_POOL - 1);
+		if (pool_recs[j].ptr == NULL)
+			break;
+
+		k = pool_hash(pool_recs[j].ptr);
+		if ((j > i && (k <= i || k > j)) || (j < i && k <= i && k > j)) {
+			pool_recs[i] = pool_recs[j];
+			i = j;
+		}
+	}
+
+	pool_recs[i].ptr = NULL;
+}
+
+void memstat_fail(uint32_t pc)
+{
+	struct memstat_site *s;
+
+	++find_pid(cur_pid(), 1)->failures;
+
+	s = find_site(pc);
+	if (s != NULL)
+		++s->failures;
+}
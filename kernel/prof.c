@@ -0,0 +1,124 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2022, Eric Enright
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * kernel/prof.c
+ *
+ * Statistical sampling profiler.  Samples are taken from the timer
+ * interrupt and hashed on (pid, pc) into a fixed table, so memory use does
+ * not depend on the size of the image or the number of tasks.
+ */
+
+#include <sys/prof.h>
+#include <sys/sched.h>
+#include <sys/kernel.h>
+#include <sys/irq.h>
+
+#include <syscall.h>
+#include <types.h>
+#include <string.h>
+
+struct prof_bucket prof_buckets[PROF_BUCKETS];
+uint32_t prof_samples = 0;	// Samples recorded
+uint32_t prof_dropped = 0;	// Samples lost to a crowded table or counter
+
+static int prof_interval = 0;	// Ticks between samples, 0 when stopped
+static int prof_countdown = 0;
+
+void prof_start(int interval)
+{
+	if (interval <= 0)
+		interval = 1;
+
+	prof_countdown = interval;
+	prof_interval = interval;
+}
+
+void prof_stop(void)
+{
+	prof_interval = 0;
+}
+
+// The table is updated from the timer interrupt, so tasks reset it through
+// SYS_PROF_RESET where IRQs are masked
+void prof_reset(void)
+{
+	int interval = prof_interval;
+
+	if (self != kernel_self) {
+		_syscall(SYS_PROF_RESET);
+		return;
+	}
+
+	prof_interval = 0;
+	memset(prof_buckets, 0, sizeof(prof_buckets));
+	prof_samples = 0;
+	prof_dropped = 0;
+	prof_interval = interval;
+}
+
+// Called from the timer interrupt
+void prof_tick(void)
+{
+	struct prof_bucket *b;
+	uint32_t pc;
+	int pid;
+	int i, h;
+
+	if (prof_interval == 0 || --prof_countdown > 0)
+		return;
+
+	prof_countdown = prof_interval;
+
+	pc = irq_pc >> PROF_PC_SHIFT;
+	pid = cur != NULL ? cur->pid : 0;
+
+	// Open addressing with a short linear probe; an empty bucket has no
+	// count
+	h = ((pc >> 2) ^ (pc >> 12) ^ (pid << 5)) & (PROF_BUCKETS - 1);
+	for (i = 0; i < PROF_PROBES; ++i) {
+		b = &prof_buckets[(h + i) & (PROF_BUCKETS - 1)];
+
+		if (b->count == 0) {
+			b->pc = pc;
+			b->pid = pid;
+		} else if (b->pc != pc || b->pid != pid) {
+			continue;
+		}
+
+		if (b->count == 0xFFFF)
+			break;
+
+		++b->count;
+		++prof_samples;
+		return;
+	}
+
+	++prof_dropped;
+}
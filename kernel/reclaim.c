@@ -0,0 +1,116 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2022, Eric Enright
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * kernel/reclaim.c
+ *
+ * Memory pressure handling.  Subsystems holding memory they can do without
+ * register shrinkers.  When the allocator sees a size class or the pool
+ * drop below its low-water mark it flags pressure, and the next timer tick
+ * runs the shrinkers and wakes any task waiting on EVENT_MEM_PRESSURE so
+ * it can shed load before allocations start to fail.  An allocation which
+ * would otherwise fail runs the shrinkers itself before giving up.
+ */
+
+#include <sys/reclaim.h>
+#include <sys/proc.h>
+#include <sys/sched.h>
+#include <sys/irq.h>
+
+#include <sleep.h>
+#include <kstat.h>
+
+static struct shrinker *shrinkers = NULL;
+static int pressure_pending = 0;
+static int reclaiming = 0;
+
+int register_shrinker(struct shrinker *s)
+{
+	uint32_t flags;
+
+	if (s == NULL || s->shrink == NULL)
+		return -1;
+
+	flags = irq_save();
+	s->next = shrinkers;
+	shrinkers = s;
+	irq_restore(flags);
+
+	return 0;
+}
+
+int mem_reclaim(int urgent)
+{
+	struct shrinker *s;
+	uint32_t flags;
+	int freed = 0;
+
+	flags = irq_save();
+
+	// A shrinker freeing memory must not end up back in here
+	if (!reclaiming) {
+		reclaiming = 1;
+
+		for (s = shrinkers; s != NULL; s = s->next)
+			freed += s->shrink(urgent);
+
+		if (urgent)
+			++kstat.reclaim.direct;
+		else
+			++kstat.reclaim.runs;
+		kstat.reclaim.freed += freed;
+
+		reclaiming = 0;
+	}
+
+	irq_restore(flags);
+
+	return freed;
+}
+
+void mem_pressure(void)
+{
+	if (!pressure_pending) {
+		pressure_pending = 1;
+		++kstat.reclaim.pressure;
+	}
+}
+
+void mem_reclaim_tick(void)
+{
+	if (!pressure_pending)
+		return;
+
+	pressure_pending = 0;
+
+	mem_reclaim(0);
+
+	if (proc_event_raise(EVENT_MEM_PRESSURE, NULL))
+		request_schedule();
+}
@@ -30,15 +30,20 @@
 #include <sys/kernel.h>
 #include <sys/proc.h>
 #include <sys/mem.h>
+#include <sys/slab.h>
 #include <sys/irq.h>
 #include <sys/timers.h>
+#include <sys/trace.h>
+#include <sys/vm.h>
 
 #include <cons.h>
+#include <syscall.h>
 #include <string.h>
 #include <types.h>
 #include <stdio.h>
 #include <sleep.h>
 #include <proc.h>
+#include <kstat.h>
 
 #define PROC_STACK_SIZE	4096	// 4k stack
 
@@ -48,6 +53,7 @@ void user_cpu_idle(void);
 // @@@ use a hash table
 static struct proc *procs = NULL;
 static struct proc *idle_task = NULL;
+static struct kmem_cache *proc_cache = NULL;
 struct proc *cur = NULL;
 static int next_pid = 0;
 
@@ -67,6 +73,8 @@ static int init_self(struct self *s)
 	s->stdout.buf_enable = 1;
 	s->stdout.buf_last = 1;
 
+	s->heap = NULL;
+
 	return 0;
 }
 
@@ -80,7 +88,7 @@ struct proc * do_spawn(void (*entry)(void), const char *name, enum proc_mode mod
 		spsr = 0x1F;	// SYS mode @@@ arch specific!
 
 	// @@@ shouldn't mix memory regions, proc stucts and proc stacks
-	proc = malloc(sizeof(struct proc));
+	proc = kmem_cache_alloc(proc_cache);
 	if (proc != NULL) {
 		memset(proc, 0, sizeof(struct proc));
 
@@ -90,8 +98,12 @@ struct proc * do_spawn(void (*entry)(void), const char *name, enum proc_mode mod
 		proc->timer.ticks_wakeup = 0xFFFFFFFF;
 		strncpy(proc->name, name, sizeof(proc->name));
 
-		// Allocate a stack
-		proc->stack_base = malloc(PROC_STACK_SIZE);
+		// Allocate a stack, in a private arena for user tasks if one
+		// is left
+		if (mode == PROC_USER)
+			proc->stack_base = vm_arena_alloc(proc, PROC_STACK_SIZE);
+		if (proc->stack_base == NULL)
+			proc->stack_base = malloc(PROC_STACK_SIZE);
 		if (proc->stack_base == NULL)
 			goto out_err;
 
@@ -118,8 +130,7 @@ struct proc * do_spawn(void (*entry)(void), const char *name, enum proc_mode mod
 		SP = 0;			// r10
 		SP = 0;			// r11
 		SP = 0;			// r12
-		SP = (uint32_t)proc->stack + PROC_STACK_SIZE - 4;
-					// r13 / sp
+		SP = (uint32_t)proc->stack;	// r13 / sp
 		SP = (uint32_t)entry;	// r14 / lr
 		#undef SP
 
@@ -140,35 +151,131 @@ struct proc * do_spawn(void (*entry)(void), const char *name, enum proc_mode mod
 out_err:
 
 	if (proc != NULL) {
-		if (proc->stack_base != NULL)
+		if (proc->arena != NULL)
+			vm_arena_free(proc);
+		else if (proc->stack_base != NULL)
 			free(proc->stack_base);
 
 		if (proc->self != NULL)
 			free(proc->self);
 
-		free(proc);
+		kmem_cache_free(proc_cache, proc);
 	}
 
 	return NULL;
 }
 
+// Setting up an arena and taking memory from the kernel heap both need a
+// privileged mode, so tasks spawn through SYS_SPAWN
 struct proc * spawn(void (*entry)(void), const char *name, enum proc_mode mode)
 {
 	struct proc *proc;
+	uint32_t flags;
+
+	if (self != kernel_self)
+		return (struct proc *)__syscall3(SYS_SPAWN, (uint32_t)entry,
+			(uint32_t)name, mode);
 
 	proc = do_spawn(entry, name, mode);
 	if (proc != NULL) {
-		cli(); // @@@ spin lock, save irq mask, etc
+		flags = irq_save();
 		if (procs == NULL)
 			procs = proc;
 		else
 			list_add_after(procs, proc);
-		sti();
+		irq_restore(flags);
 	}
 
 	return proc;
 }
 
+// Stop a process for good and release its heap and arena.  The descriptor
+// and self stay behind, as the process may still be on a wait queue, and so
+// does a stack from the kernel heap.
+void proc_kill(struct proc *p)
+{
+	int i;
+
+	p->state = PROC_KILLED;
+	p->timer.ticks_wakeup = 0xFFFFFFFF;
+	p->timer.next = 0;		// An alarm must not revive it
+	p->event_mask = 0;
+
+	for (i = 0; i < PROC_HEAP_GRANTS; ++i) {
+		if (p->heap[i] != NULL) {
+			if (p->arena == NULL)
+				free(p->heap[i]);
+			p->heap[i] = NULL;
+		}
+	}
+
+	// An arena goes back whole, stack included
+	vm_arena_free(p);
+	p->heap_size = 0;
+
+	if (p->self != NULL)
+		p->self->heap = NULL;
+
+	request_schedule();
+}
+
+// Make runnable every process except skip which is waiting on any event
+// in mask.  Returns non-zero if any process was woken.
+int proc_event_raise(uint32_t mask, struct proc *skip)
+{
+	struct proc *p = procs;
+	int hit = 0;
+
+	if (p == NULL)
+		return 0;
+
+	do {
+		if (p != skip && (p->event_mask & mask)) {
+			hit = 1;
+			p->state = PROC_RUN;
+			p->event_mask &= ~mask;
+			++kstat.sched.wakeups;
+			trace_event(TRACE_WAKEUP, p->pid);
+		}
+
+		p = (struct proc *)p->list.next;
+	} while (p != procs);
+
+	return hit;
+}
+
+// Grant a process another region for its user heap.  Returns NULL if the
+// process is at its limit or memory is short.
+void * proc_heap_grant(struct proc *p, size_t size)
+{
+	void *mem;
+	int i;
+
+	size = (size + PROC_HEAP_ALIGN - 1) & ~(PROC_HEAP_ALIGN - 1);
+	if (size == 0 || p->heap_size + size > PROC_HEAP_MAX)
+		return NULL;
+
+	for (i = 0; i < PROC_HEAP_GRANTS; ++i)
+		if (p->heap[i] == NULL)
+			break;
+
+	if (i == PROC_HEAP_GRANTS)
+		return NULL;
+
+	// Arena heaps are contiguous, so later grants extend earlier ones
+	if (p->arena != NULL)
+		mem = vm_arena_grow(p, size);
+	else
+		mem = memalign(PROC_HEAP_ALIGN, size);
+	if (mem == NULL)
+		return NULL;
+
+	p->heap[i] = mem;
+	p->heap_size += size;
+
+	return mem;
+}
+
 void request_schedule(void)
 {
 	if (sched_enabled)
@@ -195,6 +302,8 @@ static void check_timers(struct proc *p)
 		if (clkticks >= p->timer.next) {
 			// Yes, handle it and place on run queue
 			handle_task_timer(p);
+			++kstat.sched.wakeups;
+			trace_event(TRACE_WAKEUP, p->pid);
 
 			// This task is now eligible to run
 			goto out;
@@ -213,6 +322,8 @@ static void check_timers(struct proc *p)
 			// Yes, select it
 			p->timer.ticks_wakeup = 0xFFFFFFFF;
 			p->state = PROC_RUN;
+			++kstat.sched.wakeups;
+			trace_event(TRACE_WAKEUP, p->pid);
 			goto out;
 		}
 	}
@@ -223,8 +334,17 @@ out:
 
 static void swtch(struct proc *next)
 {
+	if (next != cur) {
+		++kstat.sched.switches;
+		trace_event(TRACE_SWITCH, next->pid);
+		vm_switch(next);
+	}
+
 	next->state = PROC_ACTIVE;
 
+	if (kstat.boot.first_task == 0 && next != idle_task)
+		kstat.boot.first_task = debug_timer_read();
+
 	cur = next;
 	self = cur->self;
 }
@@ -303,13 +423,16 @@ void sched_init(void)
 
 	self = kernel_self;
 
+	proc_cache = kmem_cache_create("proc", sizeof(struct proc),
+		KMEM_CACHE_ALIGN, NULL);
+
 	//idle_task = do_spawn(idle, PROC_SVC);
 	idle_task = do_spawn(idle, "[idle]", PROC_SYSTEM);
-        idle_task->state = PROC_SLEEP;
 	if (idle_task == NULL) {
 		cons_write(sched_init_err, sizeof(sched_init_err));
 		while (1);	// @@@ panic()
 	}
+	idle_task->state = PROC_SLEEP;
 
 	// Required for early printf
 	cur = idle_task;
@@ -0,0 +1,354 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2022, Eric Enright
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * kernel/slab.c
+ *
+ * Object caches for fixed-size kernel objects.  Each cache carves
+ * KMEM_SLAB_SIZE chunks from malloc() into objects of its exact size and
+ * keeps them on an intrusive free list, so allocation and free are a
+ * handful of instructions and never round up to the next size class.
+ */
+
+#include <sys/slab.h>
+#include <sys/mem.h>
+#include <sys/irq.h>
+#include <sys/reclaim.h>
+
+#include <string.h>
+#include <kstat.h>
+
+// Free objects are kept on intrusive singly linked lists.  This overlays
+// the first word of a free object.
+struct kmem_obj {
+	struct kmem_obj *next;
+};
+
+// Header at the start of every slab.  Slabs are aligned to their size, so
+// any object's slab is found by masking its address.
+struct kmem_slab {
+	struct kmem_slab *next;
+	int in_use;			// Objects handed out from this slab
+};
+
+#define obj_slab(o)	((struct kmem_slab *) \
+	((uint32_t)(o) & ~(KMEM_SLAB_SIZE - 1)))
+
+static struct kmem_cache *caches = NULL;
+static int num_caches = 0;
+
+// Statistics for caches created after the kstat slots run out
+static struct kstat_slab kmem_stat_spare;
+
+static int kmem_shrink(int urgent);
+
+static struct shrinker kmem_shrinker = {
+	.name = "slab",
+	.shrink = kmem_shrink,
+};
+
+// Add a slab's worth of objects to the cache.  Returns non-zero on error.
+static int kmem_cache_grow(struct kmem_cache *cache)
+{
+	struct kmem_slab *slab;
+	struct kmem_obj *head = NULL, *tail = NULL, *o;
+	uint32_t flags;
+	void *p;
+	int i;
+
+	// A plain malloc() may be served from the pool, which only aligns to
+	// 8 bytes
+	slab = memalign(KMEM_SLAB_SIZE, KMEM_SLAB_SIZE);
+	if (slab == NULL)
+		return -1;
+
+	slab->in_use = 0;
+
+	// Objects are packed against the end of the slab.  The slab is
+	// aligned to its size and size is a multiple of align, so every
+	// object is aligned.
+	p = (void *)slab + KMEM_SLAB_SIZE;
+	for (i = 0; i < cache->per_slab; ++i) {
+		p -= cache->size;
+		o = p;
+
+		if (cache->ctor != NULL)
+			cache->ctor(o);
+
+		o->next = head;
+		head = o;
+		if (tail == NULL)
+			tail = o;
+	}
+
+	flags = irq_save();
+
+	tail->next = cache->free_list;
+	cache->free_list = head;
+	cache->free += cache->per_slab;
+
+	slab->next = cache->slabs;
+	cache->slabs = slab;
+
+	cache->stat->total += cache->per_slab;
+	++cache->stat->slabs;
+
+	irq_restore(flags);
+
+	return 0;
+}
+
+/*
+ * Create a cache of objects of the given size.  align must be a power of
+ * two, or 0 for word alignment.  If ctor is given it runs once on each
+ * object as its slab is created; objects should be freed back in their
+ * constructed state, except for the first word which the free list uses.
+ *
+ * Caches are never destroyed, so the descriptor comes from smalloc().
+ */
+struct kmem_cache * kmem_cache_create(const char *name, size_t size,
+	size_t align, void (*ctor)(void *))
+{
+	struct kmem_cache *cache;
+	struct kstat_slab *stat;
+
+	if (align < sizeof(struct kmem_obj))
+		align = sizeof(struct kmem_obj);
+	if (size < sizeof(struct kmem_obj))
+		size = sizeof(struct kmem_obj);
+
+	size = (size + align - 1) & ~(align - 1);
+	if (size > KMEM_SLAB_SIZE - sizeof(struct kmem_slab))
+		return NULL;
+
+	cache = smalloc(sizeof(struct kmem_cache));
+	if (cache == NULL)
+		return NULL;
+
+	memset(cache, 0, sizeof(struct kmem_cache));
+	cache->name = name;
+	cache->size = size;
+	cache->align = align;
+	cache->ctor = ctor;
+	cache->per_slab = (KMEM_SLAB_SIZE - sizeof(struct kmem_slab)) / size;
+
+	if (num_caches < KSTAT_SLABS)
+		stat = &kstat.slab[num_caches];
+	else
+		stat = &kmem_stat_spare;
+
+	strncpy(stat->name, name, sizeof(stat->name) - 1);
+	stat->size = size;
+	cache->stat = stat;
+
+	if (caches == NULL)
+		register_shrinker(&kmem_shrinker);
+
+	cache->next = caches;
+	caches = cache;
+	++num_caches;
+
+	return cache;
+}
+
+void * kmem_cache_alloc(struct kmem_cache *cache)
+{
+	struct kmem_obj *o;
+	uint32_t flags;
+
+	flags = irq_save();
+
+	while (cache->free_list == NULL) {
+		// Grow outside the critical section; malloc() protects itself
+		irq_restore(flags);
+
+		if (kmem_cache_grow(cache)) {
+			++cache->stat->failures;
+			return NULL;
+		}
+
+		flags = irq_save();
+	}
+
+	o = cache->free_list;
+	cache->free_list = o->next;
+	--cache->free;
+	++obj_slab(o)->in_use;
+
+	if (++cache->stat->in_use > cache->stat->peak)
+		cache->stat->peak = cache->stat->in_use;
+
+	irq_restore(flags);
+
+	return o;
+}
+
+void kmem_cache_free(struct kmem_cache *cache, void *obj)
+{
+	struct kmem_obj *o = obj;
+	uint32_t flags;
+
+	if (obj == NULL)
+		return;
+
+	flags = irq_save();
+
+	o->next = cache->free_list;
+	cache->free_list = o;
+	++cache->free;
+	--obj_slab(o)->in_use;
+	--cache->stat->in_use;
+
+	irq_restore(flags);
+}
+
+/*
+ * Allocate n objects into objs[] under a single critical section.  Either
+ * all n are allocated and n is returned, or none are and 0 is returned.
+ */
+int kmem_cache_alloc_bulk(struct kmem_cache *cache, void **objs, int n)
+{
+	struct kmem_obj *o;
+	uint32_t flags;
+	int i;
+
+	flags = irq_save();
+
+	while (cache->free < n) {
+		irq_restore(flags);
+
+		if (kmem_cache_grow(cache)) {
+			++cache->stat->failures;
+			return 0;
+		}
+
+		flags = irq_save();
+	}
+
+	for (i = 0; i < n; ++i) {
+		o = cache->free_list;
+		cache->free_list = o->next;
+		++obj_slab(o)->in_use;
+		objs[i] = o;
+	}
+
+	cache->free -= n;
+	cache->stat->in_use += n;
+	if (cache->stat->in_use > cache->stat->peak)
+		cache->stat->peak = cache->stat->in_use;
+
+	irq_restore(flags);
+
+	return n;
+}
+
+void kmem_cache_free_bulk(struct kmem_cache *cache, void **objs, int n)
+{
+	struct kmem_obj *o;
+	uint32_t flags;
+	int i;
+
+	flags = irq_save();
+
+	for (i = 0; i < n; ++i) {
+		o = objs[i];
+		o->next = cache->free_list;
+		cache->free_list = o;
+		--obj_slab(o)->in_use;
+	}
+
+	cache->free += n;
+	cache->stat->in_use -= n;
+
+	irq_restore(flags);
+}
+
+/*
+ * Return empty slabs to malloc().  Unless urgent, one empty slab is kept
+ * back so a cache cycling around a slab boundary does not thrash.
+ * Returns the number of slabs released.
+ */
+int kmem_cache_shrink(struct kmem_cache *cache, int urgent)
+{
+	struct kmem_slab **sp, *slab, *release = NULL;
+	struct kmem_obj **op;
+	uint32_t flags;
+	int keep = !urgent;
+	int n = 0;
+
+	flags = irq_save();
+
+	// Unlink the empty slabs, marking them with in_use -1 so their
+	// objects can be picked off the free list
+	for (sp = &cache->slabs; (slab = *sp) != NULL; ) {
+		if (slab->in_use == 0 && keep-- <= 0) {
+			*sp = slab->next;
+			slab->in_use = -1;
+			slab->next = release;
+			release = slab;
+			++n;
+		} else {
+			sp = &slab->next;
+		}
+	}
+
+	if (n > 0) {
+		for (op = &cache->free_list; *op != NULL; ) {
+			if (obj_slab(*op)->in_use < 0)
+				*op = (*op)->next;
+			else
+				op = &(*op)->next;
+		}
+
+		cache->free -= n * cache->per_slab;
+		cache->stat->total -= n * cache->per_slab;
+		cache->stat->slabs -= n;
+	}
+
+	irq_restore(flags);
+
+	while (release != NULL) {
+		slab = release;
+		release = slab->next;
+		free(slab);
+	}
+
+	return n;
+}
+
+static int kmem_shrink(int urgent)
+{
+	struct kmem_cache *cache;
+	int n = 0;
+
+	for (cache = caches; cache != NULL; cache = cache->next)
+		n += kmem_cache_shrink(cache, urgent);
+
+	return n;
+}
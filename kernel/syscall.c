@@ -33,9 +33,17 @@
  * Main system call implementation.
  */
 
+#include "../config.h"
+
 #include <sys/kernel.h>
 #include <sys/sched.h>
+#include <sys/proc.h>
 #include <sys/list.h>
+#include <sys/irq.h>
+#include <sys/timers.h>
+#include <sys/trace.h>
+#include <sys/prof.h>
+#include <sys/cons.h>
 
 #include <syscall.h>
 #include <types.h>
@@ -43,6 +51,10 @@
 #include <sleep.h>
 #include <kstat.h>
 
+#ifdef CONFIG_NET
+#	include "../net/dll/arp.h"
+#endif
+
 static int sys_wait(uint32_t *args)
 {
 	struct completion *c = (struct completion *)*args;
@@ -73,6 +85,8 @@ int sys_wake(uint32_t *args)
 	// Dequeue the entire wait queue and add each proc to the run list
 	while (NULL != (proc = (struct proc *)bfifo_dequeue(c->wait))) {
 		proc->state = PROC_RUN;
+		++kstat.sched.wakeups;
+		trace_event(TRACE_WAKEUP, proc->pid);
 	}
 
 	return 0;
@@ -99,21 +113,9 @@ static int sys_yield(uint32_t *arg)
 static int sys_event_set(uint32_t *arg)
 {
 	uint32_t mask = *arg;
-	struct proc *p;
-	int hit = 0;
-
-	// Walk the process list and wake up anyone waiting on this mask
-	for (		p = (struct proc *)cur->list.next;
-			p != cur;
-			p = (struct proc *)p->list.next) {
-		if (p->event_mask & mask) {
-			hit = 1;
-			p->state = PROC_RUN;
-			p->event_mask &= ~mask;
-		}
-	}
 
-	if (hit)
+	// Wake up anyone else waiting on this mask
+	if (proc_event_raise(mask, cur))
 		request_schedule();
 
 	return 0;
@@ -158,48 +160,95 @@ static int sys_reset(uint32_t *arg)
 	return 0;
 }
 
-static int sys_kstat(uint32_t *arg)
+// Grant the caller another region for its heap, returning its address or
+// 0 on failure
+static int sys_heap_grow(uint32_t *arg)
 {
-	struct kstat *uptr = (struct kstat *)*arg;
+	return (int)proc_heap_grant(cur, *arg);
+}
 
-	memset(uptr, 0, sizeof(struct kstat));
+static int sys_exit(uint32_t *arg)
+{
+	proc_kill(cur);
 
 	return 0;
 }
 
+static int sys_cons_write(uint32_t *arg)
+{
+	return cons_tx((const void *)arg[0], arg[1]);
+}
+
+static int sys_cons_read(uint32_t *arg)
+{
+	return cons_rx((void *)arg[0], arg[1]);
+}
+
+static int sys_spawn(uint32_t *arg)
+{
+	return (int)spawn((void (*)(void))arg[0], (const char *)arg[1], arg[2]);
+}
+
 #ifdef CONFIG_NET
-static int sys_netstat(uint32_t *arg)
+static int sys_arp_snapshot(uint32_t *arg)
 {
-	struct netstat *uptr = (struct netstat *)*arg;
-	struct en_eth_if *eth_if;
+	return en_arp_cache_snapshot((struct en_arp_entry *)arg[0], arg[1]);
+}
+#endif
 
-	memset(uptr, 0, sizeof(struct netstat));
+#ifdef CONFIG_IRQSTAT
+static int sys_irqstat_reset(uint32_t *arg)
+{
+	irqstat_reset();
 
-	eth_if = (struct en_eth_if *)eth_if_list.next;
-	if (eth_if != NULL) {
-		strcpy(uptr->eth.name, eth_if->name);
-		memcpy(&uptr->eth.stats, &eth_if->stats, sizeof(uptr->eth.stats));
-	} else {
-		printf("eth_if is null?\r\n");
-	}
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_PROF
+static int sys_prof_reset(uint32_t *arg)
+{
+	prof_reset();
+
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_TRACE
+static int sys_trace_clear(uint32_t *arg)
+{
+	trace_clear();
 
 	return 0;
 }
 #endif
 
 static void *syscall_table[] = {
-	sys_wait,	// 0
-	sys_wake,	// 1
-	sys_sleep,	// 2
-	sys_yield,	// 3
-	sys_event_set,	// 4
-	sys_event_wait,	// 5
-	sys_alarm,	// 6
-	sys_utt_done,	// 7
-	sys_reset,	// 8
-	sys_kstat,	// 9
+	[SYS_WAIT]		= sys_wait,
+	[SYS_WAKE]		= sys_wake,
+	[SYS_SLEEP]		= sys_sleep,
+	[SYS_YIELD]		= sys_yield,
+	[SYS_EVENT_SET]		= sys_event_set,
+	[SYS_EVENT_WAIT]	= sys_event_wait,
+	[SYS_ALARM]		= sys_alarm,
+	[SYS_UTT_DONE]		= sys_utt_done,
+	[SYS_RESET]		= sys_reset,
+	[SYS_HEAP_GROW]		= sys_heap_grow,
+	[SYS_EXIT]		= sys_exit,
+	[SYS_CONS_WRITE]	= sys_cons_write,
+	[SYS_CONS_READ]		= sys_cons_read,
+	[SYS_SPAWN]		= sys_spawn,
 #ifdef CONFIG_NET
-	sys_netstat,	// 10
+	[SYS_ARP_SNAPSHOT]	= sys_arp_snapshot,
+#endif
+#ifdef CONFIG_IRQSTAT
+	[SYS_IRQSTAT_RESET]	= sys_irqstat_reset,
+#endif
+#ifdef CONFIG_PROF
+	[SYS_PROF_RESET]	= sys_prof_reset,
+#endif
+#ifdef CONFIG_TRACE
+	[SYS_TRACE_CLEAR]	= sys_trace_clear,
 #endif
 };
 
@@ -208,10 +257,18 @@ int c_svc(uint32_t num, uint32_t *regs)
 	uint32_t real_num = *regs;
 	int (*func)(uint32_t *regs);
 	int rc = -1;
+#ifdef CONFIG_IRQSTAT
+	uint32_t start = debug_timer_read();
+#endif
 
 	self = kernel_self;
 
-	if (real_num > (sizeof(syscall_table) >> 2)) {
+	++kstat.sched.syscalls;
+	trace_event(TRACE_SYSCALL_ENTRY, real_num);
+
+	if (real_num >= (sizeof(syscall_table) >> 2)
+		|| syscall_table[real_num] == NULL) {
+
 		printf("invalid syscall: 0x%x\r\n", real_num);
 		rc = -1;
 	} else {
@@ -219,6 +276,12 @@ int c_svc(uint32_t num, uint32_t *regs)
 		rc = func(regs + 1);
 	}
 
+	trace_event(TRACE_SYSCALL_EXIT, rc);
+
+#ifdef CONFIG_IRQSTAT
+	irqstat_svc(real_num, debug_timer_read() - start);
+#endif
+
 	self = cur->self;
 
 	return rc;
@@ -34,6 +34,8 @@
  */
 
 #include <sys/sched.h>
+#include <sys/prof.h>
+#include <sys/reclaim.h>
 
 #include <types.h>
 
@@ -45,6 +47,12 @@ void timer_int(void)
 	// Bump the kernel clock
 	++clkticks;
 
+	// Sample the interrupted PC
+	prof_tick();
+
+	// Trim caches if memory ran low since the last tick
+	mem_reclaim_tick();
+
 	// Schedule another user task
 	request_schedule();
 }
@@ -0,0 +1,458 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2022, Eric Enright
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * kernel/tlsf.c
+ *
+ * Two-Level Segregated Fit allocator, after Masmano et al., "TLSF: a New
+ * Dynamic Memory Allocator for Real-Time Systems".  Free blocks are kept
+ * on lists indexed by a first level (power of two) and second level
+ * (linear subdivision of that power of two).  Two bitmaps record which
+ * lists are non-empty, so finding a fitting block, and freeing one with
+ * immediate coalescing, both take a bounded number of steps.
+ *
+ * None of these functions protect themselves from concurrent access.
+ */
+
+#include <sys/tlsf.h>
+#include <sys/bitops.h>
+
+#include <string.h>
+
+#define TLSF_ALIGN_SHIFT	3
+#define TLSF_ALIGN		(1 << TLSF_ALIGN_SHIFT)
+#define TLSF_SL_SHIFT		4	// 16 second level lists
+#define TLSF_SL_COUNT		(1 << TLSF_SL_SHIFT)
+#define TLSF_FL_SHIFT		(TLSF_SL_SHIFT + TLSF_ALIGN_SHIFT)
+#define TLSF_FL_MAX		25	// Blocks up to 32MB
+#define TLSF_FL_COUNT		(TLSF_FL_MAX - TLSF_FL_SHIFT + 1)
+#define TLSF_SMALL_BLOCK	(1 << TLSF_FL_SHIFT)
+
+// Every block starts with prev_phys and size.  The free list links overlay
+// the payload, so they only exist while the block is free.
+struct tlsf_block {
+	struct tlsf_block *prev_phys;	// Physically preceding block
+	size_t size;			// Payload size | BLOCK_FREE
+	struct tlsf_block *next_free;
+	struct tlsf_block *prev_free;
+};
+
+#define BLOCK_FREE		0x1
+#define BLOCK_MIN		(2 * sizeof(struct tlsf_block *))
+#define BLOCK_HDR		(sizeof(struct tlsf_block) - BLOCK_MIN)
+#define BLOCK_MAX		((1 << TLSF_FL_MAX) - 1)
+
+struct tlsf {
+	uint32_t fl_bitmap;
+	uint32_t sl_bitmap[TLSF_FL_COUNT];
+	struct tlsf_block *blocks[TLSF_FL_COUNT][TLSF_SL_COUNT];
+	size_t size;			// Payload bytes in the initial block
+};
+
+#define align_up(x, a)		(((uint32_t)(x) + (a) - 1) & ~((a) - 1))
+#define align_down(x, a)	((uint32_t)(x) & ~((a) - 1))
+
+static inline size_t block_size(struct tlsf_block *b)
+{
+	return b->size & ~BLOCK_FREE;
+}
+
+static inline int block_is_free(struct tlsf_block *b)
+{
+	return b->size & BLOCK_FREE;
+}
+
+static inline void * block_payload(struct tlsf_block *b)
+{
+	return (void *)b + BLOCK_HDR;
+}
+
+static inline struct tlsf_block * payload_block(void *ptr)
+{
+	return (struct tlsf_block *)(ptr - BLOCK_HDR);
+}
+
+static inline struct tlsf_block * block_next(struct tlsf_block *b)
+{
+	return (struct tlsf_block *)(block_payload(b) + block_size(b));
+}
+
+// List indices holding blocks of exactly this size
+static void mapping_insert(size_t size, int *fl, int *sl)
+{
+	int f;
+
+	if (size < TLSF_SMALL_BLOCK) {
+		*fl = 0;
+		*sl = size >> TLSF_ALIGN_SHIFT;
+	} else {
+		f = fls(size) - 1;
+		*sl = (size >> (f - TLSF_SL_SHIFT)) ^ TLSF_SL_COUNT;
+		*fl = f - (TLSF_FL_SHIFT - 1);
+	}
+}
+
+// List indices where every block is at least this size
+static void mapping_search(size_t size, int *fl, int *sl)
+{
+	if (size >= TLSF_SMALL_BLOCK)
+		size += (1 << (fls(size) - 1 - TLSF_SL_SHIFT)) - 1;
+
+	mapping_insert(size, fl, sl);
+}
+
+static void insert_free_block(struct tlsf *t, struct tlsf_block *b)
+{
+	struct tlsf_block *head;
+	int fl, sl;
+
+	mapping_insert(block_size(b), &fl, &sl);
+
+	head = t->blocks[fl][sl];
+	b->next_free = head;
+	b->prev_free = NULL;
+	if (head != NULL)
+		head->prev_free = b;
+	t->blocks[fl][sl] = b;
+
+	t->fl_bitmap |= 1 << fl;
+	t->sl_bitmap[fl] |= 1 << sl;
+}
+
+static void remove_free_block(struct tlsf *t, struct tlsf_block *b)
+{
+	int fl, sl;
+
+	mapping_insert(block_size(b), &fl, &sl);
+
+	if (b->next_free != NULL)
+		b->next_free->prev_free = b->prev_free;
+
+	if (b->prev_free != NULL) {
+		b->prev_free->next_free = b->next_free;
+	} else {
+		t->blocks[fl][sl] = b->next_free;
+
+		if (b->next_free == NULL) {
+			t->sl_bitmap[fl] &= ~(1 << sl);
+			if (t->sl_bitmap[fl] == 0)
+				t->fl_bitmap &= ~(1 << fl);
+		}
+	}
+}
+
+// Find and unlink a free block of at least size bytes
+static struct tlsf_block * take_free_block(struct tlsf *t, size_t size)
+{
+	struct tlsf_block *b;
+	uint32_t map;
+	int fl, sl;
+
+	mapping_search(size, &fl, &sl);
+	if (fl >= TLSF_FL_COUNT)
+		return NULL;
+
+	// Anything left at this first level?
+	map = t->sl_bitmap[fl] & (~0U << sl);
+	if (map == 0) {
+		// No, take the smallest larger first level
+		map = t->fl_bitmap & (~0U << (fl + 1));
+		if (map == 0)
+			return NULL;
+
+		fl = ffs(map) - 1;
+		map = t->sl_bitmap[fl];
+	}
+	sl = ffs(map) - 1;
+
+	b = t->blocks[fl][sl];
+	remove_free_block(t, b);
+
+	return b;
+}
+
+// Merge a free block with its free physical neighbours.  The neighbours
+// are unlinked; b itself must not be on a free list.
+static struct tlsf_block * merge_free_block(struct tlsf *t,
+	struct tlsf_block *b)
+{
+	struct tlsf_block *n;
+
+	n = block_next(b);
+	if (block_is_free(n)) {
+		remove_free_block(t, n);
+		b->size += block_size(n) + BLOCK_HDR;
+		block_next(b)->prev_phys = b;
+	}
+
+	n = b->prev_phys;
+	if (n != NULL && block_is_free(n)) {
+		remove_free_block(t, n);
+		n->size += block_size(b) + BLOCK_HDR;
+		block_next(n)->prev_phys = n;
+		b = n;
+	}
+
+	return b;
+}
+
+// Trim a used block to size, returning any worthwhile tail to the pool
+static void trim_used_block(struct tlsf *t, struct tlsf_block *b, size_t size)
+{
+	struct tlsf_block *r;
+
+	if (block_size(b) < size + sizeof(struct tlsf_block))
+		return;
+
+	r = (struct tlsf_block *)(block_payload(b) + size);
+	r->size = (block_size(b) - size - BLOCK_HDR) | BLOCK_FREE;
+	r->prev_phys = b;
+	block_next(r)->prev_phys = r;
+	b->size = size;
+
+	insert_free_block(t, merge_free_block(t, r));
+}
+
+static inline size_t adjust_size(size_t size)
+{
+	if (size < BLOCK_MIN)
+		return BLOCK_MIN;
+
+	return align_up(size, TLSF_ALIGN);
+}
+
+// Turn a region into a single free block.  Returns its size, or 0 if the
+// region is too small or too large to manage.
+static size_t add_region(struct tlsf *t, void *mem, size_t size)
+{
+	struct tlsf_block *b, *sentinel;
+	void *end;
+	size_t free;
+
+	b = (struct tlsf_block *)align_up(mem, TLSF_ALIGN);
+	end = (void *)align_down(mem + size, TLSF_ALIGN);
+
+	// The free block is followed by a zero sized used block so the last
+	// real block always has a neighbour to look at
+	if ((void *)b + 2 * BLOCK_HDR + BLOCK_MIN > end)
+		return 0;
+
+	free = end - (void *)b - 2 * BLOCK_HDR;
+	if (free > BLOCK_MAX)
+		return 0;
+
+	b->prev_phys = NULL;
+	b->size = free | BLOCK_FREE;
+
+	sentinel = block_next(b);
+	sentinel->prev_phys = b;
+	sentinel->size = 0;
+
+	insert_free_block(t, b);
+
+	return free;
+}
+
+/*
+ * Create a pool covering mem.  Returns NULL if the region is too small or
+ * too large to manage.
+ */
+struct tlsf * tlsf_create(void *mem, size_t size)
+{
+	struct tlsf *t;
+	void *start;
+
+	t = (struct tlsf *)align_up(mem, TLSF_ALIGN);
+	start = (void *)t + sizeof(struct tlsf);
+	if (start >= mem + size)
+		return NULL;
+
+	memset(t, 0, sizeof(struct tlsf));
+
+	t->size = add_region(t, start, mem + size - start);
+	if (t->size == 0)
+		return NULL;
+
+	return t;
+}
+
+/*
+ * Add another region to a pool.  Blocks never span regions.  Returns
+ * non-zero on error.
+ */
+int tlsf_add_pool(struct tlsf *t, void *mem, size_t size)
+{
+	size_t free;
+
+	free = add_region(t, mem, size);
+	if (free == 0)
+		return -1;
+
+	t->size += free;
+
+	return 0;
+}
+
+void * tlsf_malloc(struct tlsf *t, size_t size)
+{
+	struct tlsf_block *b;
+
+	if (size == 0 || size > BLOCK_MAX)
+		return NULL;
+
+	size = adjust_size(size);
+
+	b = take_free_block(t, size);
+	if (b == NULL)
+		return NULL;
+
+	b->size &= ~BLOCK_FREE;
+	trim_used_block(t, b, size);
+
+	return block_payload(b);
+}
+
+/*
+ * Allocate size bytes aligned to align, which must be a power of two.
+ */
+void * tlsf_memalign(struct tlsf *t, size_t align, size_t size)
+{
+	struct tlsf_block *b, *a;
+	uint32_t p, gap;
+
+	if (align <= TLSF_ALIGN)
+		return tlsf_malloc(t, size);
+
+	if (size == 0 || size > BLOCK_MAX)
+		return NULL;
+
+	size = adjust_size(size);
+
+	// Leave room to split off a leading free block of any offset
+	b = take_free_block(t, size + align + sizeof(struct tlsf_block));
+	if (b == NULL)
+		return NULL;
+
+	p = (uint32_t)block_payload(b);
+	gap = align_up(p, align) - p;
+	if (gap != 0 && gap < sizeof(struct tlsf_block))
+		gap += align_up(sizeof(struct tlsf_block) - gap, align);
+
+	if (gap != 0) {
+		// Give the leading gap back as a free block
+		a = (struct tlsf_block *)((void *)b + gap);
+		a->size = block_size(b) - gap;
+		a->prev_phys = b;
+		block_next(a)->prev_phys = a;
+
+		b->size = (gap - BLOCK_HDR) | BLOCK_FREE;
+		insert_free_block(t, b);
+
+		b = a;
+	} else {
+		b->size &= ~BLOCK_FREE;
+	}
+
+	trim_used_block(t, b, size);
+
+	return block_payload(b);
+}
+
+/*
+ * Resize an allocation, growing in place into a following free block when
+ * possible.
+ */
+void * tlsf_realloc(struct tlsf *t, void *ptr, size_t size)
+{
+	struct tlsf_block *b, *n;
+	void *p;
+
+	if (ptr == NULL)
+		return tlsf_malloc(t, size);
+
+	if (size == 0) {
+		tlsf_free(t, ptr);
+		return NULL;
+	}
+
+	if (size > BLOCK_MAX)
+		return NULL;
+
+	b = payload_block(ptr);
+	size = adjust_size(size);
+
+	if (size > block_size(b)) {
+		n = block_next(b);
+		if (!block_is_free(n)
+			|| block_size(b) + BLOCK_HDR + block_size(n) < size) {
+
+			// Can't grow in place, move it
+			p = tlsf_malloc(t, size);
+			if (p != NULL) {
+				memcpy(p, ptr, block_size(b));
+				tlsf_free(t, ptr);
+			}
+
+			return p;
+		}
+
+		remove_free_block(t, n);
+		b->size += block_size(n) + BLOCK_HDR;
+		block_next(b)->prev_phys = b;
+	}
+
+	trim_used_block(t, b, size);
+
+	return ptr;
+}
+
+void tlsf_free(struct tlsf *t, void *ptr)
+{
+	struct tlsf_block *b;
+
+	if (ptr == NULL)
+		return;
+
+	b = payload_block(ptr);
+	b->size |= BLOCK_FREE;
+
+	insert_free_block(t, merge_free_block(t, b));
+}
+
+// Usable size of an allocation
+size_t tlsf_block_size(void *ptr)
+{
+	return block_size(payload_block(ptr));
+}
+
+// Bytes available to allocate from an empty pool, over all regions
+size_t tlsf_pool_size(struct tlsf *t)
+{
+	return t->size;
+}
@@ -0,0 +1,121 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2022, Eric Enright
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * kernel/trace.c
+ *
+ * Kernel event trace ring buffer.  The writer side lives in sys/trace.h so
+ * that trace points stay cheap; this file holds the ring itself and the
+ * reader side used by the console.
+ */
+
+#include <sys/trace.h>
+#include <sys/timers.h>
+#include <sys/kernel.h>
+#include <sys/sched.h>
+
+#include <syscall.h>
+#include <types.h>
+#include <string.h>
+
+struct trace_rec trace_ring[TRACE_ENTRIES];
+volatile uint32_t trace_head = 0;
+int trace_enabled = 0;
+
+void trace_start(void)
+{
+	trace_enabled = 1;
+}
+
+void trace_stop(void)
+{
+	trace_enabled = 0;
+}
+
+// The writer runs with IRQs masked, which only privileged code can do, so
+// tasks clear the ring through SYS_TRACE_CLEAR
+void trace_clear(void)
+{
+	int enabled = trace_enabled;
+
+	if (self != kernel_self) {
+		_syscall(SYS_TRACE_CLEAR);
+		return;
+	}
+
+	trace_enabled = 0;
+	memset(trace_ring, 0, sizeof(trace_ring));
+	trace_head = 0;
+	trace_enabled = enabled;
+}
+
+// Copy up to max records, starting at *pos, into buf.  *pos is a free
+// running sequence number; start with 0 and pass it back in to continue
+// where the last call left off.  Records overwritten by the writer before
+// they could be copied are skipped, and *pos jumps forward accordingly.
+//
+// Returns the number of records copied.
+int trace_read(struct trace_rec *buf, int max, uint32_t *pos)
+{
+	uint32_t head, start, valid;
+	int n, skip;
+
+	head = trace_head;
+
+	// The oldest record still in the ring
+	start = *pos;
+	if (head - start > TRACE_ENTRIES)
+		start = head - TRACE_ENTRIES;
+
+	n = head - start;
+	if (n > max)
+		n = max;
+
+	for (skip = 0; skip < n; ++skip)
+		buf[skip] = trace_ring[(start + skip) & (TRACE_ENTRIES - 1)];
+
+	// Drop anything the writer lapped while we were copying
+	head = trace_head;
+	valid = start;
+	if (head - valid > TRACE_ENTRIES)
+		valid = head - TRACE_ENTRIES;
+
+	skip = valid - start;
+	if (skip >= n) {
+		*pos = valid;
+		return 0;
+	}
+
+	if (skip > 0)
+		memmove(buf, buf + skip, (n - skip) * sizeof(struct trace_rec));
+
+	*pos = start + n;
+
+	return n - skip;
+}
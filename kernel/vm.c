@@ -0,0 +1,184 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2022, Eric Enright
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * kernel/vm.c
+ *
+ * Per-task address spaces.  Memory stays identity mapped, but each user
+ * task's stack and heap live in a 1MB arena of its own which is mapped a
+ * page at a time through a coarse page table.  Every arena is in its own
+ * ARM domain, and a context switch only reloads the domain access control
+ * register so that the incoming task can reach its arena and no other.
+ * The TLB and caches are left alone.
+ *
+ * Everything else, kernel included, stays in the shared domain.  Tasks
+ * still call into the kernel and read its globals directly, so this keeps
+ * tasks away from each other's stacks and heaps rather than away from the
+ * kernel.  Objects shared between tasks must not live on a stack.
+ *
+ * Tasks beyond the number of arenas, and system tasks, fall back to the
+ * kernel heap.
+ */
+
+#include "../config.h"
+
+#include <sys/vm.h>
+#include <sys/proc.h>
+#include <sys/mem.h>
+#include <sys/irq.h>
+
+#include "../arch/mmu.h"
+
+#define VM_PAGE_FLAGS	(MMU_AP_SRW_URW | MMU_WRITEBACK)
+
+static void *arena_base = NULL;	// First arena, domain 0
+static int arenas = 0;		// Arenas which fit in RAM
+static uint32_t arena_used = 0;	// Bit n set if arena n is taken
+
+// Claim the RAM above the kernel heap for arenas, one section each
+void vm_init(void)
+{
+	uint32_t base;
+#ifdef ENABLE_MMU
+	int i, tables;
+
+	// The first coarse table maps the section holding the tables, so
+	// that tasks can neither read nor rewrite any of them
+	_mmu_protect_tables(__pgt__, __dma_data__ - (char *)__ttb__);
+	tables = (__dma_data__ - (char *)__pgt__) / MMU_COARSE_SIZE - 1;
+#endif
+
+	base = (uint32_t)_heap_start + _heap_size;
+	base = (base + VM_ARENA_SIZE - 1) & ~(VM_ARENA_SIZE - 1);
+	if (base >= VM_RAM_END)
+		return;
+
+	arena_base = (void *)base;
+	arenas = (VM_RAM_END - base) >> VM_ARENA_SHIFT;
+	if (arenas > VM_ARENAS)
+		arenas = VM_ARENAS;
+
+#ifdef ENABLE_MMU
+	if (arenas > tables)
+		arenas = tables;
+
+	for (i = 0; i < arenas; ++i)
+		_mmu_coarse(arena_base + (i << VM_ARENA_SHIFT),
+			__pgt__ + (i + 1) * (MMU_COARSE_SIZE / 4), i);
+#endif
+}
+
+/*
+ * Give p an arena, with stack bytes mapped at the top of it for its stack.
+ * Returns the stack base, or NULL if no arena is free.  Privileged only,
+ * like everything else here; tasks get here through SYS_SPAWN.
+ */
+void * vm_arena_alloc(struct proc *p, size_t stack)
+{
+	uint32_t flags;
+	int i;
+
+	flags = irq_save();
+
+	for (i = 0; i < arenas; ++i)
+		if (!(arena_used & (1 << i)))
+			break;
+
+	if (i < arenas)
+		arena_used |= 1 << i;
+
+	irq_restore(flags);
+
+	if (i == arenas)
+		return NULL;
+
+	p->domain = i;
+	p->arena = arena_base + (i << VM_ARENA_SHIFT);
+
+#ifdef ENABLE_MMU
+	_mmu_map_pages(p->arena + VM_ARENA_SIZE - stack, stack, VM_PAGE_FLAGS);
+#endif
+
+	return p->arena + VM_ARENA_SIZE - stack;
+}
+
+// Map size more bytes of heap above what p has.  Returns their start.
+void * vm_arena_grow(struct proc *p, size_t size)
+{
+	void *mem = p->arena + p->heap_size;
+
+	// Keep at least an unmapped page between the heap and the stack
+	if (p->heap_size + size > VM_ARENA_SIZE - (p->arena + VM_ARENA_SIZE
+			- p->stack_base) - PROC_HEAP_ALIGN)
+		return NULL;
+
+#ifdef ENABLE_MMU
+	_mmu_map_pages(mem, size, VM_PAGE_FLAGS);
+#endif
+
+	return mem;
+}
+
+/*
+ * Unmap p's heap and stack and hand its arena back.  p must not run again:
+ * this is for a task being killed, which by then is in the kernel on the
+ * SVC stack and never returns to its own.
+ */
+void vm_arena_free(struct proc *p)
+{
+	uint32_t flags;
+
+	if (p->arena == NULL)
+		return;
+
+#ifdef ENABLE_MMU
+	_mmu_unmap_pages(p->arena, p->heap_size);
+	_mmu_unmap_pages(p->stack_base, p->arena + VM_ARENA_SIZE
+		- p->stack_base);
+#endif
+
+	flags = irq_save();
+	arena_used &= ~(1 << p->domain);
+	irq_restore(flags);
+
+	p->arena = NULL;
+}
+
+// Make p's arena the only one accessible
+void vm_switch(struct proc *p)
+{
+#ifdef ENABLE_MMU
+	uint32_t dacr = dacr_client(MMU_DOMAIN_KERNEL);
+
+	if (p->arena != NULL)
+		dacr |= dacr_client(p->domain);
+
+	_mmu_set_domains(dacr);
+#endif
+}
@@ -0,0 +1,82 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2022, Eric Enright
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * lib/crc_arm.s
+ *
+ * Inner loop of the slice-by-4 CRC32, see crc.c.  Each word is folded into
+ * the CRC and its four bytes looked up in four tables at once, so there is
+ * no chain of dependent lookups as in the byte at a time loop.
+ */
+
+	.text
+	.code 32
+	.align 4
+
+	.global crc32_words
+	.func crc32_words
+	/*
+	 * Entry: r0: crc (register, not inverted), r1: buf (word aligned),
+	 * r2: number of words
+	 *
+	 * Return: r0 is crc advanced over the words of buf
+	 */
+crc32_words:
+	stmdb	sp!, {r4-r7,lr}
+	ldr	r4, =crc32_table
+	add	r5, r4, #1024
+	add	r6, r4, #2048
+	add	r7, r4, #3072
+	subs	r2, r2, #1
+	blt	.Lcrc_done
+
+.Lcrc_word:
+	ldr	r3, [r1], #4
+	eor	r0, r0, r3
+
+	and	r3, r0, #0xff
+	and	ip, r0, #0xff00
+	ldr	r3, [r7, r3, lsl #2]	@ byte 0 through table 3
+	ldr	ip, [r6, ip, lsr #6]	@ byte 1 through table 2
+	and	lr, r0, #0xff0000
+	mov	r0, r0, lsr #24
+	ldr	lr, [r5, lr, lsr #14]	@ byte 2 through table 1
+	ldr	r0, [r4, r0, lsl #2]	@ byte 3 through table 0
+	eor	r3, r3, ip
+	eor	r3, r3, lr
+	eor	r0, r0, r3
+
+	subs	r2, r2, #1
+	bge	.Lcrc_word
+
+.Lcrc_done:
+	ldmia	sp!, {r4-r7,pc}
+	.endfunc
+
+	.end
@@ -0,0 +1,113 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2022, Eric Enright
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * lib/heap.c
+ *
+ * Per-process user heap.  Each process manages its own TLSF pool in
+ * regions granted by the kernel, so allocation never touches kernel
+ * allocator state and only enters the kernel when the heap has to grow.
+ * Regions are released by the kernel when the process is killed.
+ */
+
+#include <sys/sched.h>
+#include <sys/tlsf.h>
+
+#include <heap.h>
+#include <syscall.h>
+
+#define HEAP_GROW_MIN	0x4000	// Smallest region requested, 16k
+#define HEAP_OVERHEAD	0x0800	// Pool control structure and headers
+
+// Ask the kernel for a region big enough to satisfy size and add it to the
+// heap.  Returns non-zero on error.
+static int heap_grow(size_t size)
+{
+	void *mem;
+
+	// TLSF rounds requests up by as much as 1/16th when searching, so
+	// leave room for that as well as the overhead
+	size += (size >> 3) + HEAP_OVERHEAD;
+
+	// Double the heap each time so the kernel's limit on regions per
+	// process does not bound the heap size
+	if (self->heap != NULL && size < tlsf_pool_size(self->heap))
+		size = tlsf_pool_size(self->heap);
+
+	size = (size + HEAP_GROW_MIN - 1) & ~(HEAP_GROW_MIN - 1);
+
+	mem = (void *)__syscall(SYS_HEAP_GROW, size);
+	if (mem == NULL)
+		return -1;
+
+	if (self->heap == NULL) {
+		self->heap = tlsf_create(mem, size);
+		if (self->heap == NULL)
+			return -1;
+
+		return 0;
+	}
+
+	return tlsf_add_pool(self->heap, mem, size);
+}
+
+void * umalloc(size_t size)
+{
+	void *p = NULL;
+
+	if (self->heap != NULL)
+		p = tlsf_malloc(self->heap, size);
+
+	if (p == NULL && size > 0 && heap_grow(size) == 0)
+		p = tlsf_malloc(self->heap, size);
+
+	return p;
+}
+
+void * urealloc(void *ptr, size_t size)
+{
+	void *p;
+
+	if (ptr == NULL)
+		return umalloc(size);
+
+	p = tlsf_realloc(self->heap, ptr, size);
+
+	// The original allocation is untouched on failure
+	if (p == NULL && size > 0 && heap_grow(size) == 0)
+		p = tlsf_realloc(self->heap, ptr, size);
+
+	return p;
+}
+
+void ufree(void *ptr)
+{
+	if (ptr != NULL && self->heap != NULL)
+		tlsf_free(self->heap, ptr);
+}
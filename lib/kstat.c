@@ -33,15 +33,62 @@
  * Kernel/system statistics and information.
  */
 
+#include "../config.h"
+
 #include <kstat.h>
-#include <syscall.h>
+#include <string.h>
 
+// Statistics are read straight out of the kernel under the sequence count
+// rather than through a system call, so polling them costs the kernel
+// nothing and never masks interrupts.
 int kstat_get(struct kstat *ptr)
 {
-	return __syscall(SYS_KSTAT, (uint32_t)ptr);
+	uint32_t seq;
+
+	do {
+		seq = seq_read_begin(&kstat.seq);
+		memcpy(ptr, &kstat, sizeof(struct kstat));
+	} while (seq_read_retry(&kstat.seq, seq));
+
+	return 0;
+}
+
+// Copy out the statistics of every interface.  The caller provides any
+// consistency guarantee; see netstat_get().
+void netstat_copy(struct netstat *ptr)
+{
+#ifdef CONFIG_NET
+	struct list *p;
+	struct en_eth_if *eth_if;
+	int i = 0;
+#endif
+
+	memset(ptr, 0, sizeof(struct netstat));
+	ptr->version = NETSTAT_VERSION;
+	ptr->size = sizeof(struct netstat);
+
+#ifdef CONFIG_NET
+	for (p = eth_if_list.next; p != NULL && i < NETSTAT_IFS; p = p->next) {
+		eth_if = (struct en_eth_if *)p;
+
+		strncpy(ptr->eth[i].name, eth_if->name, EN_ETH_IF_NAMESIZE - 1);
+		memcpy(&ptr->eth[i].stats, &eth_if->stats,
+			sizeof(struct en_eth_stats));
+		++i;
+	}
+
+	ptr->num_if = i;
+#endif
 }
 
 int netstat_get(struct netstat *ptr)
 {
-	return __syscall(SYS_NETSTAT, (uint32_t)ptr);
+	uint32_t seq;
+
+	do {
+		seq = seq_read_begin(&kstat.seq);
+		netstat_copy(ptr);
+	} while (seq_read_retry(&kstat.seq, seq));
+
+	return 0;
 }
@@ -0,0 +1,240 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2022, Eric Enright
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * lib/math_arm.s
+ *
+ * Integer division, which the ARM920T has no instruction for.
+ *
+ * The general routines shift the divisor up to the dividend's top bit,
+ * found by binary search as there is no clz on ARMv4, and then jump into
+ * an unrolled long division at that bit.  Each quotient bit costs three
+ * instructions, and only as many bits as the quotient can have are done.
+ * Both the GCC and EABI names are provided.
+ *
+ * Division by 10, 100 and 1000 is a multiply by the reciprocal instead,
+ * see <div.h>.
+ */
+
+	.text
+	.code 32
+	.align 4
+
+	.global __udivsi3
+	.global __aeabi_uidiv
+	.global __aeabi_uidivmod
+	.func __udivsi3
+	/*
+	 * Entry: r0: num, r1: den
+	 *
+	 * Return: r0 is num / den, r1 is num % den.  Division by zero gives
+	 * a quotient of 0 and a remainder of num.
+	 *
+	 * Only r0-r3 are touched.
+	 */
+__udivsi3:
+__aeabi_uidiv:
+__aeabi_uidivmod:
+.Ludivmod:
+	cmp	r1, #0
+	beq	.Lless
+	cmp	r0, r1
+	bcc	.Lless
+
+	/* r3 = bits the quotient can have - 1 = clz(den) - clz(num) */
+	mov	r3, #0
+	mov	r2, r1
+	cmp	r2, #0x10000
+	addcc	r3, r3, #16
+	movcc	r2, r2, lsl #16
+	cmp	r2, #0x1000000
+	addcc	r3, r3, #8
+	movcc	r2, r2, lsl #8
+	cmp	r2, #0x10000000
+	addcc	r3, r3, #4
+	movcc	r2, r2, lsl #4
+	cmp	r2, #0x40000000
+	addcc	r3, r3, #2
+	movcc	r2, r2, lsl #2
+	cmp	r2, #0x80000000
+	addcc	r3, r3, #1
+
+	mov	r2, r0
+	cmp	r2, #0x10000
+	subcc	r3, r3, #16
+	movcc	r2, r2, lsl #16
+	cmp	r2, #0x1000000
+	subcc	r3, r3, #8
+	movcc	r2, r2, lsl #8
+	cmp	r2, #0x10000000
+	subcc	r3, r3, #4
+	movcc	r2, r2, lsl #4
+	cmp	r2, #0x40000000
+	subcc	r3, r3, #2
+	movcc	r2, r2, lsl #2
+	cmp	r2, #0x80000000
+	subcc	r3, r3, #1
+
+	/* Skip the steps for the bits above that, three instructions each */
+	mov	r2, #0			@ r2 = quotient
+	rsb	r3, r3, #31
+	add	r3, r3, r3, lsl #1
+	add	pc, pc, r3, lsl #2	@ pc reads two instructions ahead
+	mov	r0, r0
+
+	.irp	bit, 31,30,29,28,27,26,25,24,23,22,21,20,19,18,17,16,15,14,13,12,11,10,9,8,7,6,5,4,3,2,1,0
+	cmp	r0, r1, lsl #\bit
+	subcs	r0, r0, r1, lsl #\bit
+	adc	r2, r2, r2
+	.endr
+
+	mov	r1, r0
+	mov	r0, r2
+	bx	lr
+
+.Lless:
+	mov	r1, r0
+	mov	r0, #0
+	bx	lr
+	.endfunc
+
+
+	.global __umodsi3
+	.func __umodsi3
+	/*
+	 * Entry: r0: num, r1: den
+	 *
+	 * Return: r0 is num % den
+	 */
+__umodsi3:
+	stmdb	sp!, {lr}
+	bl	.Ludivmod
+	mov	r0, r1
+	ldmia	sp!, {pc}
+	.endfunc
+
+
+	.global udivmodsi4
+	.func udivmodsi4
+	/*
+	 * Entry: r0: num, r1: den, r2: modwanted
+	 *
+	 * Return: r0 is num % den if modwanted, otherwise num / den
+	 */
+udivmodsi4:
+	stmdb	sp!, {r4,lr}
+	mov	r4, r2
+	bl	.Ludivmod
+	cmp	r4, #0
+	movne	r0, r1
+	ldmia	sp!, {r4,pc}
+	.endfunc
+
+
+	.global __divsi3
+	.global __aeabi_idiv
+	.global __aeabi_idivmod
+	.func __divsi3
+	/*
+	 * Entry: r0: num, r1: den
+	 *
+	 * Return: r0 is num / den rounded towards zero, r1 is num % den with
+	 * the sign of num
+	 */
+__divsi3:
+__aeabi_idiv:
+__aeabi_idivmod:
+.Ldivmod:
+	stmdb	sp!, {r4,r5,lr}
+	movs	r5, r0			@ r5 = sign of the remainder
+	rsbmi	r0, r0, #0
+	eor	r4, r5, r1		@ r4 = sign of the quotient
+	cmp	r1, #0
+	rsbmi	r1, r1, #0
+
+	bl	.Ludivmod
+
+	cmp	r4, #0
+	rsbmi	r0, r0, #0
+	cmp	r5, #0
+	rsbmi	r1, r1, #0
+	ldmia	sp!, {r4,r5,pc}
+	.endfunc
+
+
+	.global __modsi3
+	.func __modsi3
+	/*
+	 * Entry: r0: num, r1: den
+	 *
+	 * Return: r0 is num % den, with the sign of num
+	 */
+__modsi3:
+	stmdb	sp!, {lr}
+	bl	.Ldivmod
+	mov	r0, r1
+	ldmia	sp!, {pc}
+	.endfunc
+
+
+	/*
+	 * Entry: r0: n
+	 *
+	 * Return: r0 is n / 10^k, as the high word of n times 2^s / 10^k
+	 * rounded up, shifted down by s - 32.  The constants are exact for
+	 * every 32-bit n.
+	 */
+	.global udiv10
+	.func udiv10
+udiv10:
+	ldr	r1, =0xcccccccd		@ 2^35 / 10
+	umull	r2, r3, r0, r1
+	mov	r0, r3, lsr #3
+	bx	lr
+	.endfunc
+
+	.global udiv100
+	.func udiv100
+udiv100:
+	ldr	r1, =0x51eb851f		@ 2^37 / 100
+	umull	r2, r3, r0, r1
+	mov	r0, r3, lsr #5
+	bx	lr
+	.endfunc
+
+	.global udiv1000
+	.func udiv1000
+udiv1000:
+	ldr	r1, =0x10624dd3		@ 2^38 / 1000
+	umull	r2, r3, r0, r1
+	mov	r0, r3, lsr #6
+	bx	lr
+	.endfunc
+
+	.end
@@ -87,3 +87,8 @@ int reset(void)
 {
 	return _syscall(SYS_RESET);
 }
+
+int exit(void)
+{
+	return _syscall(SYS_EXIT);
+}
@@ -31,6 +31,9 @@
 #include <sleep.h>
 #include <proc.h>
 #include <sys/sched.h>
+#include <div.h>
+#include <string.h>
+#include <types.h>
 
 // Stolen from host libc
 #include <stdarg.h>
@@ -66,6 +69,41 @@ void putchar(char c)
 	}
 }
 
+// Queue n chars in one go, flushing after each newline like putchar()
+static void stdout_write(const char *s, int n)
+{
+	int i, run;
+
+	if (!self->stdout.buf_enable) {
+		cons_write(s, n);
+		return;
+	}
+
+	while (n > 0) {
+		if (self->stdout.idx >= STDOUT_SIZE)
+			flush();
+
+		run = STDOUT_SIZE - self->stdout.idx;
+		if (run > n)
+			run = n;
+
+		for (i = 0; i < run; ++i) {
+			if (s[i] == '\n') {
+				run = i + 1;
+				break;
+			}
+		}
+
+		memcpy(self->stdout.ptr + self->stdout.idx, s, run);
+		self->stdout.idx += run;
+		s += run;
+		n -= run;
+
+		if (s[-1] == '\n')
+			flush();
+	}
+}
+
 void puthexchar(char c)
 {
 	char x;
@@ -86,8 +124,7 @@ void puthexchar(char c)
 
 static void _puts(const char *s)
 {
-	while (*s != '\0')
-		putchar(*s++);
+	stdout_write(s, strlen(s));
 }
 
 void puts(const char *s)
@@ -97,130 +134,347 @@ void puts(const char *s)
 	putchar('\n');
 }
 
-static int printf_d(int d)
+// Where formatted output goes
+struct fmt_out {
+	char	*buf;		// Caller's buffer, if not to_stdout
+	size_t	size;		// Bytes in buf, including the nul
+	int	to_stdout;
+	int	len;		// Chars produced, whether or not they fit
+};
+
+static const char fmt_digits2[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+static const char fmt_lower[] = "0123456789abcdef";
+static const char fmt_upper[] = "0123456789ABCDEF";
+
+static void fmt_write(struct fmt_out *o, const char *s, int n)
 {
-	int num = 0;
-	char buf[10];	// Max 11 chars in sint32_t (+1 for -)
-	int i = 0;
-
-	// Quick handling of zero
-	if (d == 0) {
-		putchar('0');
-		return 1;
-	}
+	int room;
 
-	// Is this a negative number?
-	if (d & 0x80000000) {
-		// Yes, convert to positive and add '-' to output
-		// @@@ implement abs() ?
-		--d;
-		d = ~d;
-		putchar('-');
-	}
+	if (n <= 0)
+		return;
 
-	// Find out how many digits are in this number
-	while (d > 0) {
-		buf[i++] = (d % 10) + '0';
-		d /= 10;
+	if (o->to_stdout) {
+		stdout_write(s, n);
+	} else if (o->len + 1 < (int)o->size) {
+		room = o->size - 1 - o->len;
+		memcpy(o->buf + o->len, s, n < room ? n : room);
 	}
 
-	num = i;
+	o->len += n;
+}
+
+static void fmt_pad(struct fmt_out *o, char c, int n)
+{
+	char pad[16];
 
-	// Now reverse number the characters
-	while (i > 0)
-		putchar(buf[--i]);
+	if (n <= 0)
+		return;
 
-	return num;
+	memset(pad, c, sizeof(pad));
+	for (; n > sizeof(pad); n -= sizeof(pad))
+		fmt_write(o, pad, sizeof(pad));
+	fmt_write(o, pad, n);
 }
 
-static int printf_x(uint32_t x)
+// Write the decimal digits of u, two at a time, ending just before end.
+// Returns the first digit.
+static char * fmt_u32(char *end, uint32_t u)
 {
-	uint8_t c;
-	int n = 0;
-
-	c = (x & 0xFF000000) >> 24;
-	if (c) {
-		puthexchar(c);
-		n += 2;
+	uint32_t q, r;
+
+	while (u >= 100) {
+		q = udiv100(u);
+		r = (u - q * 100) * 2;
+		end -= 2;
+		end[0] = fmt_digits2[r];
+		end[1] = fmt_digits2[r + 1];
+		u = q;
 	}
 
-	c = (x & 0x00FF0000) >> 16;
-	if (c || n) {
-		puthexchar(c);
-		n += 2;
+	if (u >= 10) {
+		end -= 2;
+		end[0] = fmt_digits2[u * 2];
+		end[1] = fmt_digits2[u * 2 + 1];
+	} else {
+		*--end = '0' + u;
 	}
 
-	c = (x & 0x0000FF00) >> 8;
-	if (c || n) {
-		puthexchar(c);
-		n += 2;
-	}
+	return end;
+}
+
+// Divide the 64-bit w[1]:w[0] by 100 in place, returning the remainder.
+// Goes 16 bits at a time so that it needs only 32-bit arithmetic.
+static uint32_t fmt_div100(uint32_t *w)
+{
+	uint32_t r = 0, cur, hi, lo;
+	int i;
 
-	c = x & 0xFF;
-	if (c || n) {
-		puthexchar(c);
-		n += 2;
+	for (i = 1; i >= 0; --i) {
+		cur = (r << 16) | (w[i] >> 16);
+		hi = udiv100(cur);
+		r = cur - hi * 100;
+
+		cur = (r << 16) | (w[i] & 0xffff);
+		lo = udiv100(cur);
+		r = cur - lo * 100;
+
+		w[i] = (hi << 16) | lo;
 	}
 
-	if (!n) {
-		putchar('0');
-		++n;
+	return r;
+}
+
+static char * fmt_u64(char *end, uint32_t *w)
+{
+	uint32_t r;
+
+	while (w[1] != 0) {
+		r = fmt_div100(w) * 2;
+		end -= 2;
+		end[0] = fmt_digits2[r];
+		end[1] = fmt_digits2[r + 1];
 	}
 
-	return n;
+	return fmt_u32(end, w[0]);
 }
 
-// This return value can not be trusted
-int printf(char *fmt, ...)
+// Write at least min hex digits of x ending just before end
+static char * fmt_hex(char *end, uint32_t x, const char *digits, int min)
 {
-	va_list ap;
-	int d;
-	uint32_t x;
-	const char *s;
-	int chars = 0;
+	char *stop = end - min;
 
-	va_start(ap, fmt);
+	do {
+		*--end = digits[x & 0xf];
+		x >>= 4;
+	} while (x != 0 || end > stop);
+
+	return end;
+}
+
+/*
+ * Format into o.  Supports %d %i %u %x %X %p %c %s and %%, the flags - and
+ * 0, a width (or *), a precision for %s, and l / ll for long and long long.
+ * Literal text is copied in runs.  Returns the number of chars produced.
+ */
+static int fmt_format(struct fmt_out *o, const char *fmt, va_list ap)
+{
+	union {
+		uint64_t v;
+		uint32_t w[2];		// Little endian
+	} n;
+	char buf[24];			// Enough for a uint64_t in decimal
+	char *end = buf + sizeof(buf);
+	const char *run, *p, *pre;
+	const char *digits;
+	int left, zero, width, prec, longs;
+	int len, prelen, pad;
 
 	while (*fmt != '\0') {
+		// Copy everything up to the next conversion in one go
+		for (run = fmt; *fmt != '\0' && *fmt != '%'; ++fmt)
+			;
+		fmt_write(o, run, fmt - run);
+		if (*fmt == '\0')
+			break;
+		++fmt;
+
+		left = zero = width = longs = 0;
+		prec = -1;
+
+		for (;; ++fmt) {
+			if (*fmt == '-')
+				left = 1;
+			else if (*fmt == '0')
+				zero = 1;
+			else
+				break;
+		}
+
+		if (*fmt == '*') {
+			width = va_arg(ap, int);
+			if (width < 0) {
+				left = 1;
+				width = -width;
+			}
+			++fmt;
+		} else {
+			while (*fmt >= '0' && *fmt <= '9')
+				width = width * 10 + *fmt++ - '0';
+		}
+
+		if (*fmt == '.') {
+			++fmt;
+			prec = 0;
+			if (*fmt == '*') {
+				prec = va_arg(ap, int);
+				++fmt;
+			} else {
+				while (*fmt >= '0' && *fmt <= '9')
+					prec = prec * 10 + *fmt++ - '0';
+			}
+		}
+
+		for (; *fmt == 'l' || *fmt == 'h' || *fmt == 'z'; ++fmt)
+			if (*fmt == 'l')
+				++longs;
+
+		pre = "";
+		n.w[1] = 0;
+
 		switch (*fmt) {
-		case '%':	// Format requested
-			switch (*++fmt) {
-				case 'd':	// Decimal
-					d = va_arg(ap, int);
-					chars += printf_d(d);
-					break;
-
-				case 'x':
-					x = va_arg(ap, uint32_t);
-					chars += printf_x(x);
-					break;
-
-				case 's':
-					s = va_arg(ap, const char *);
-					// @@@ _puts does not return chars written
-					_puts(s);
-					break;
-
-				case '%':	// Pass through
-				default:	// Unknown format, pass though
-					putchar(*fmt);
-					break;
+		case 'd':
+		case 'i':
+			if (longs > 1) {
+				n.v = va_arg(ap, int64_t);
+			} else {
+				n.w[0] = va_arg(ap, int);
+				if (n.w[0] & 0x80000000)
+					n.w[1] = 0xffffffff;
+			}
+
+			if (n.w[1] & 0x80000000) {
+				pre = "-";
+				n.w[0] = -n.w[0];
+				n.w[1] = ~n.w[1] + (n.w[0] == 0);
+			}
+			p = fmt_u64(end, n.w);
+			break;
+
+		case 'u':
+			if (longs > 1)
+				n.v = va_arg(ap, uint64_t);
+			else
+				n.w[0] = va_arg(ap, uint32_t);
+			p = fmt_u64(end, n.w);
+			break;
+
+		case 'p':
+			pre = "0x";
+			// Fall through
+		case 'x':
+		case 'X':
+			digits = *fmt == 'X' ? fmt_upper : fmt_lower;
+			if (*fmt == 'p')
+				n.w[0] = (uint32_t)va_arg(ap, void *);
+			else if (longs > 1)
+				n.v = va_arg(ap, uint64_t);
+			else
+				n.w[0] = va_arg(ap, uint32_t);
+
+			if (n.w[1] != 0) {
+				p = fmt_hex(end, n.w[0], digits, 8);
+				p = fmt_hex((char *)p, n.w[1], digits, 1);
+			} else {
+				p = fmt_hex(end, n.w[0], digits, 1);
 			}
+			break;
+
+		case 'c':
+			buf[0] = va_arg(ap, int);
+			p = buf;
+			zero = 0;
+			break;
 
+		case 's':
+			p = va_arg(ap, const char *);
+			if (p == NULL)
+				p = "(null)";
+			zero = 0;
 			break;
 
-		default:	// Unmolested character
-			putchar(*fmt);
-			chars += 1;
+		case '\0':			// Stray % at the end
+			continue;
+
+		case '%':
+		default:			// Unknown, pass it through
+			p = fmt;
+			zero = 0;
 			break;
 		}
 
+		if (*fmt == 's') {
+			// Only look as far as the precision allows
+			for (len = 0; (prec < 0 || len < prec) && p[len] != '\0';
+					++len)
+				;
+		} else if (p == buf || p == fmt) {
+			len = 1;
+		} else {
+			len = end - p;
+		}
+
+		prelen = strlen(pre);
+		pad = width - len - prelen;
+
+		if (!left && !zero)
+			fmt_pad(o, ' ', pad);
+		fmt_write(o, pre, prelen);
+		if (!left && zero)
+			fmt_pad(o, '0', pad);
+		fmt_write(o, p, len);
+		if (left)
+			fmt_pad(o, ' ', pad);
+
 		++fmt;
 	}
 
+	return o->len;
+}
+
+// Like the C library's: output is truncated to fit, but the return value
+// is the length it would have had
+int vsnprintf(char *buf, size_t size, const char *fmt, va_list ap)
+{
+	struct fmt_out o = { buf, size, 0, 0 };
+
+	fmt_format(&o, fmt, ap);
+
+	if (size > 0)
+		buf[o.len < (int)size ? o.len : size - 1] = '\0';
+
+	return o.len;
+}
+
+int snprintf(char *buf, size_t size, const char *fmt, ...)
+{
+	va_list ap;
+	int len;
+
+	va_start(ap, fmt);
+	len = vsnprintf(buf, size, fmt, ap);
+	va_end(ap);
+
+	return len;
+}
+
+int vprintf(const char *fmt, va_list ap)
+{
+	struct fmt_out o = { NULL, 0, 1, 0 };
+
+	return fmt_format(&o, fmt, ap);
+}
+
+int printf(const char *fmt, ...)
+{
+	va_list ap;
+	int len;
+
+	va_start(ap, fmt);
+	len = vprintf(fmt, ap);
 	va_end(ap);
 
-	return chars;
+	return len;
 }
 
 int getchar(void)
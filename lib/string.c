@@ -29,41 +29,7 @@
 
 #include <types.h>
 
-void *memset(void *s, int c, size_t n)
-{
-	void *r = s;
-	while (n != 0) {
-		*(char *)s++ = c & 0xff;
-		--n;
-	}
-
-	return r;
-}
-
-void memcpy(void *dest, const void *src, size_t n)
-{
-	if (dest == src)
-		return;
-
-	while (n--)
-		*(char *)dest++ = *(char *)src++;
-}
-
-void memmove(void *dest, const void *src, size_t n)
-{
-	if (dest == src)
-		return;
-
-	// If dest is before src, we can use memcpy
-	if (dest < src)
-		return memcpy(dest, src, n);
-
-	// Otherwise we must perform a reverse memcpy
-	src += n - 1;
-	dest += n - 1;
-	while (n--)
-		*(char *)dest-- = *(char *)src--;
-}
+// memset(), memcpy(), memmove() and strlen() are in string_arm.s
 
 char *strcpy(char *dest, const char *src)
 {
@@ -110,16 +76,6 @@ int strcmp(const char *s1, const char *s2)
 	return 0;
 }
 
-int strlen(const char *s)
-{
-	int len = 0;
-
-	while (*s++ != '\0')
-		++len;
-
-	return len;
-}
-
 int atoi(const char *str)
 {
 	const char *p = str;
@@ -0,0 +1,313 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2022, Eric Enright
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * lib/string_arm.s
+ *
+ * Block memory operations.  Bulk data moves a cache line (eight words) at
+ * a time with ldm/stm once the destination is word aligned; a source with
+ * a different alignment is merged from aligned loads by shifting.  Tails
+ * are finished a word and then a byte at a time.
+ *
+ * Every routine reads only words which hold bytes it was asked to read, so
+ * none of them can fault past the end of a buffer.
+ */
+
+	.text
+	.code 32
+	.align 4
+
+	.global memcpy
+	.func memcpy
+	/*
+	 * Entry: r0: dest, r1: src, r2: n
+	 *
+	 * Return: r0 is dest
+	 */
+memcpy:
+.Lmemcpy:
+	stmdb	sp!, {r0,r4-r9,lr}
+	cmp	r2, #4
+	blt	.Lcpy_bytes
+
+	/* Word align dest */
+	ands	r3, r0, #3
+	beq	.Lcpy_aligned
+	rsb	r3, r3, #4		@ r3 = bytes up to the boundary
+	sub	r2, r2, r3
+.Lcpy_head:
+	ldrb	ip, [r1], #1
+	strb	ip, [r0], #1
+	subs	r3, r3, #1
+	bne	.Lcpy_head
+
+.Lcpy_aligned:
+	tst	r1, #3
+	bne	.Lcpy_shift
+
+	/* Both aligned, move a line at a time */
+	subs	r2, r2, #32
+	blt	.Lcpy_words
+.Lcpy_burst:
+	ldmia	r1!, {r3-r9,ip}
+	stmia	r0!, {r3-r9,ip}
+	subs	r2, r2, #32
+	bge	.Lcpy_burst
+
+.Lcpy_words:
+	adds	r2, r2, #(32 - 4)
+	blt	.Lcpy_tail
+.Lcpy_word:
+	ldr	r3, [r1], #4
+	str	r3, [r0], #4
+	subs	r2, r2, #4
+	bge	.Lcpy_word
+
+.Lcpy_tail:
+	add	r2, r2, #4		@ r2 = 0-3 bytes left
+.Lcpy_bytes:
+	subs	r2, r2, #1
+	ldrgeb	r3, [r1], #1
+	strgeb	r3, [r0], #1
+	bgt	.Lcpy_bytes
+
+	ldmia	sp!, {r0,r4-r9,pc}
+
+	/*
+	 * src is 1-3 bytes past a word boundary.  Each dest word is the top
+	 * of one aligned source word and the bottom of the next; r3 carries
+	 * the word loaded last.
+	 */
+.Lcpy_shift:
+	and	r3, r1, #3
+	bic	r1, r1, #3
+	mov	r5, r3, lsl #3		@ r5 = bits to drop from the low word
+	rsb	r6, r5, #32		@ r6 = bits to take from the high word
+	ldr	r3, [r1], #4
+
+	subs	r2, r2, #16
+	blt	.Lcpy_shift_words
+.Lcpy_shift_burst:
+	ldmia	r1!, {r7-r9,ip}
+	mov	r4, r3, lsr r5
+	orr	r4, r4, r7, lsl r6
+	mov	r7, r7, lsr r5
+	orr	r7, r7, r8, lsl r6
+	mov	r8, r8, lsr r5
+	orr	r8, r8, r9, lsl r6
+	mov	r9, r9, lsr r5
+	orr	r9, r9, ip, lsl r6
+	stmia	r0!, {r4,r7-r9}
+	mov	r3, ip
+	subs	r2, r2, #16
+	bge	.Lcpy_shift_burst
+
+.Lcpy_shift_words:
+	adds	r2, r2, #(16 - 4)
+	blt	.Lcpy_shift_tail
+.Lcpy_shift_word:
+	mov	r4, r3, lsr r5
+	ldr	r3, [r1], #4
+	orr	r4, r4, r3, lsl r6
+	str	r4, [r0], #4
+	subs	r2, r2, #4
+	bge	.Lcpy_shift_word
+
+.Lcpy_shift_tail:
+	sub	r1, r1, #4		@ back to the next unread byte
+	add	r1, r1, r5, lsr #3
+	b	.Lcpy_tail
+	.endfunc
+
+
+	.global memmove
+	.func memmove
+	/*
+	 * Entry: r0: dest, r1: src, r2: n
+	 *
+	 * Return: r0 is dest
+	 */
+memmove:
+	subs	r3, r0, r1		@ r3 = dest - src
+	cmphi	r2, r3			@ dest above src, but overlapping?
+	bls	.Lmemcpy		@ no, forwards is safe
+
+	/* Copy backwards from the ends */
+	stmdb	sp!, {r0,r4-r9,lr}
+	add	r0, r0, r2
+	add	r1, r1, r2
+	cmp	r2, #4
+	blt	.Lmove_bytes
+
+	/* Word copies only when both ends can be aligned together */
+	eor	r3, r0, r1
+	tst	r3, #3
+	bne	.Lmove_bytes
+
+.Lmove_head:
+	tst	r0, #3
+	ldrneb	r3, [r1, #-1]!
+	strneb	r3, [r0, #-1]!
+	subne	r2, r2, #1
+	bne	.Lmove_head
+
+	subs	r2, r2, #32
+	blt	.Lmove_words
+.Lmove_burst:
+	ldmdb	r1!, {r3-r9,ip}
+	stmdb	r0!, {r3-r9,ip}
+	subs	r2, r2, #32
+	bge	.Lmove_burst
+
+.Lmove_words:
+	adds	r2, r2, #(32 - 4)
+	blt	.Lmove_tail
+.Lmove_word:
+	ldr	r3, [r1, #-4]!
+	str	r3, [r0, #-4]!
+	subs	r2, r2, #4
+	bge	.Lmove_word
+
+.Lmove_tail:
+	add	r2, r2, #4
+.Lmove_bytes:
+	subs	r2, r2, #1
+	ldrgeb	r3, [r1, #-1]!
+	strgeb	r3, [r0, #-1]!
+	bgt	.Lmove_bytes
+
+	ldmia	sp!, {r0,r4-r9,pc}
+	.endfunc
+
+
+	.global memset
+	.func memset
+	/*
+	 * Entry: r0: s, r1: c, r2: n
+	 *
+	 * Return: r0 is s
+	 */
+memset:
+	mov	ip, r0
+	and	r1, r1, #0xff
+	orr	r1, r1, r1, lsl #8
+	orr	r1, r1, r1, lsl #16	@ r1 = c in every byte
+	cmp	r2, #4
+	blt	.Lset_bytes
+
+.Lset_head:
+	tst	r0, #3
+	strneb	r1, [r0], #1
+	subne	r2, r2, #1
+	bne	.Lset_head
+
+	subs	r2, r2, #32
+	blt	.Lset_words
+	stmdb	sp!, {r4-r9}
+	mov	r3, r1
+	mov	r4, r1
+	mov	r5, r1
+	mov	r6, r1
+	mov	r7, r1
+	mov	r8, r1
+	mov	r9, r1
+.Lset_burst:
+	stmia	r0!, {r1,r3-r9}
+	subs	r2, r2, #32
+	bge	.Lset_burst
+	ldmia	sp!, {r4-r9}
+
+.Lset_words:
+	adds	r2, r2, #(32 - 4)
+	blt	.Lset_tail
+.Lset_word:
+	str	r1, [r0], #4
+	subs	r2, r2, #4
+	bge	.Lset_word
+
+.Lset_tail:
+	add	r2, r2, #4
+.Lset_bytes:
+	subs	r2, r2, #1
+	strgeb	r1, [r0], #1
+	bgt	.Lset_bytes
+
+	mov	r0, ip
+	bx	lr
+	.endfunc
+
+
+	.global strlen
+	.func strlen
+	/*
+	 * Entry: r0: s
+	 *
+	 * Return: r0 is the length of s
+	 */
+strlen:
+	mov	r1, r0			@ r1 = start
+
+	/* Bytes up to a word boundary */
+.Llen_head:
+	tst	r0, #3
+	beq	.Llen_aligned
+	ldrb	r2, [r0], #1
+	cmp	r2, #0
+	bne	.Llen_head
+	b	.Llen_done
+
+	/*
+	 * A word w holds a zero byte iff (w - 0x01010101) & ~w & 0x80808080
+	 * is non-zero
+	 */
+.Llen_aligned:
+	mov	r3, #1
+	orr	r3, r3, r3, lsl #8
+	orr	r3, r3, r3, lsl #16	@ r3 = 0x01010101
+.Llen_word:
+	ldr	r2, [r0], #4
+	sub	ip, r2, r3
+	bic	ip, ip, r2
+	tst	ip, r3, lsl #7
+	beq	.Llen_word
+
+	/* Find which byte it was */
+	sub	r0, r0, #4
+.Llen_tail:
+	ldrb	r2, [r0], #1
+	cmp	r2, #0
+	bne	.Llen_tail
+
+.Llen_done:
+	sub	r0, r0, r1
+	sub	r0, r0, #1		@ r0 is one past the nul
+	bx	lr
+	.endfunc
+
+	.end
@@ -32,14 +32,19 @@
 	.align 4
 
 	.global __syscall
+	.global __syscall2
+	.global __syscall3
 	.func __syscall
 __syscall:
+__syscall2:
+__syscall3:
 	stmdb	sp!, {r0-r3,r12,lr}
 
 	/* no svc on compiler? same as swi */
 	swi	0x0			@ real number is in r0
 
-	ldmia	sp!, {r0-r3,r12,pc}
+	add	sp, sp, #4		@ r0 holds the return value
+	ldmia	sp!, {r1-r3,r12,pc}
 
 	.endfunc
 
@@ -0,0 +1,297 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2022, Eric Enright
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * net/core/cksum.c
+ *
+ * The Internet checksum.  The bulk of every buffer is summed a word at a
+ * time by cksum_arm.s; here the ends are trimmed to word alignment and
+ * odd starting addresses are handled by the byte swap trick of RFC 1071,
+ * section 2(B).
+ */
+
+#include <string.h>
+
+#include "cksum.h"
+
+/* Add v to a partial sum, with end-around carry */
+static inline uint32_t cksum_add(uint32_t sum, uint32_t v)
+{
+	sum += v;
+	return sum + (sum < v);
+}
+
+static inline uint16_t cksum_swap(uint16_t s)
+{
+	return (uint16_t)((s >> 8) | (s << 8));
+}
+
+/*---------------------------------------------------------------------
+ * cksum_fold()
+ *
+ * 	This function folds a partial sum down to 16 bits.
+ *
+ * Parameters:
+ *
+ * 	sum	- the partial sum
+ *
+ * Returns:
+ *
+ * 	The one's complement sum, which is 0xffff for a buffer that
+ * 	includes a correct checksum
+ */
+uint16_t cksum_fold(uint32_t sum)
+{
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (sum & 0xffff) + (sum >> 16);
+
+	return (uint16_t)sum;
+}
+
+/*---------------------------------------------------------------------
+ * cksum_partial()
+ *
+ * 	This function adds a buffer to a partial sum.  The buffer may be
+ * 	of any length and alignment, but is summed as though it starts at
+ * 	an even offset in the checksummed data; see cksum_vec() for
+ * 	buffers that do not.
+ *
+ * Parameters:
+ *
+ * 	buf	- buffer to sum
+ * 	len	- length of the buffer
+ * 	sum	- partial sum so far, zero to start
+ *
+ * Returns:
+ *
+ * 	The new partial sum
+ */
+uint32_t cksum_partial(const void *buf, size_t len, uint32_t sum)
+{
+	const uint8_t *p = buf;
+	uint32_t s = 0;
+	size_t n;
+	int odd;
+
+	if (len == 0)
+		return sum;
+
+	/* An odd start is summed one byte out, and swapped back below */
+	odd = (uint32_t)p & 1;
+	if (odd) {
+		s = *p++ << 8;
+		--len;
+	}
+
+	if (len >= 2 && ((uint32_t)p & 2)) {
+		s += *(const uint16_t *)p;
+		p += 2;
+		len -= 2;
+	}
+
+	n = len & ~3;
+	s = cksum_words(p, n, s);
+	p += n;
+	len -= n;
+
+	if (len & 2) {
+		s = cksum_add(s, *(const uint16_t *)p);
+		p += 2;
+	}
+
+	/* A trailing byte is the first of a zero-padded word */
+	if (len & 1)
+		s = cksum_add(s, *p);
+
+	s = cksum_fold(s);
+	if (odd)
+		s = cksum_swap(s);
+
+	return cksum_add(sum, s);
+}
+
+/*---------------------------------------------------------------------
+ * cksum_vec()
+ *
+ * 	This function adds scattered buffers to a partial sum, as though
+ * 	they were one contiguous buffer.
+ *
+ * Parameters:
+ *
+ * 	v	- the buffers, in order
+ * 	n	- number of buffers
+ * 	sum	- partial sum so far, zero to start
+ *
+ * Returns:
+ *
+ * 	The new partial sum
+ */
+uint32_t cksum_vec(const struct cksum_vec *v, int n, uint32_t sum)
+{
+	size_t off = 0;
+	uint16_t s;
+
+	for (; n > 0; --n, ++v) {
+		s = cksum_fold(cksum_partial(v->buf, v->len, 0));
+
+		/* Bytes after an odd length piece land in the other half */
+		if (off & 1)
+			s = cksum_swap(s);
+
+		sum = cksum_add(sum, s);
+		off += v->len;
+	}
+
+	return sum;
+}
+
+/*---------------------------------------------------------------------
+ * cksum_copy()
+ *
+ * 	This function copies a buffer and adds it to a partial sum in one
+ * 	pass.  Buffers which are not equally aligned are copied and then
+ * 	summed.
+ *
+ * Parameters:
+ *
+ * 	dst	- destination buffer
+ * 	src	- source buffer
+ * 	len	- bytes to copy
+ * 	sum	- partial sum so far, zero to start
+ *
+ * Returns:
+ *
+ * 	The new partial sum
+ */
+uint32_t cksum_copy(void *dst, const void *src, size_t len, uint32_t sum)
+{
+	const uint8_t *s = src;
+	uint8_t *d = dst;
+	uint32_t part = 0;
+	size_t n;
+
+	if ((((uint32_t)d ^ (uint32_t)s) & 3) || ((uint32_t)s & 1)) {
+		memcpy(dst, src, len);
+		return cksum_partial(dst, len, sum);
+	}
+
+	if (len >= 2 && ((uint32_t)s & 2)) {
+		*(uint16_t *)d = part = *(const uint16_t *)s;
+		d += 2;
+		s += 2;
+		len -= 2;
+	}
+
+	n = len & ~3;
+	part = cksum_copy_words(d, s, n, part);
+	d += n;
+	s += n;
+	len -= n;
+
+	if (len & 2) {
+		*(uint16_t *)d = *(const uint16_t *)s;
+		part = cksum_add(part, *(const uint16_t *)s);
+		d += 2;
+		s += 2;
+	}
+
+	if (len & 1) {
+		*d = *s;
+		part = cksum_add(part, *s);
+	}
+
+	return cksum_add(sum, cksum_fold(part));
+}
+
+/*---------------------------------------------------------------------
+ * cksum()
+ *
+ * 	This function computes the checksum of a buffer.
+ *
+ * Parameters:
+ *
+ * 	buf	- buffer to sum
+ * 	len	- length of the buffer
+ *
+ * Returns:
+ *
+ * 	The checksum, ready to be stored in a header
+ */
+uint16_t cksum(const void *buf, size_t len)
+{
+	return ~cksum_fold(cksum_partial(buf, len, 0));
+}
+
+/*---------------------------------------------------------------------
+ * cksum_update16()
+ *
+ * 	This function updates a checksum after a 16-bit word it covers has
+ * 	changed, per RFC 1624 eqn. 3.  Words are as they sit in memory.
+ *
+ * Parameters:
+ *
+ * 	cksum	- the checksum as stored
+ * 	old	- the word before the change
+ * 	new	- the word after the change
+ *
+ * Returns:
+ *
+ * 	The new checksum
+ */
+uint16_t cksum_update16(uint16_t cksum, uint16_t old, uint16_t new)
+{
+	uint32_t sum;
+
+	sum = (uint16_t)~cksum + (uint16_t)~old + new;
+
+	return ~cksum_fold(sum);
+}
+
+/*---------------------------------------------------------------------
+ * cksum_update32()
+ *
+ * 	This function updates a checksum after an aligned 32-bit word it
+ * 	covers, such as an IP address, has changed.
+ *
+ * Parameters:
+ *
+ * 	cksum	- the checksum as stored
+ * 	old	- the word before the change
+ * 	new	- the word after the change
+ *
+ * Returns:
+ *
+ * 	The new checksum
+ */
+uint16_t cksum_update32(uint16_t cksum, uint32_t old, uint32_t new)
+{
+	cksum = cksum_update16(cksum, old >> 16, new >> 16);
+
+	return cksum_update16(cksum, old & 0xffff, new & 0xffff);
+}
@@ -0,0 +1,65 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2022, Eric Enright
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * net/core/cksum.h
+ *
+ * The Internet checksum (RFC 1071).
+ *
+ * Sums are kept as 32-bit partial sums, of 16-bit words in the order they
+ * sit in memory, and only folded to 16 bits at the end.  As the one's
+ * complement sum does not care about byte order, checksums computed this
+ * way can be stored and compared without swapping.
+ */
+
+#ifndef _CORE_CKSUM_H
+#define _CORE_CKSUM_H
+
+#include <types.h>
+
+/* One piece of a scattered buffer, such as a pseudo-header */
+struct cksum_vec {
+	const void	*buf;
+	size_t		 len;
+};
+
+uint32_t cksum_partial(const void *buf, size_t len, uint32_t sum);
+uint32_t cksum_vec(const struct cksum_vec *v, int n, uint32_t sum);
+uint32_t cksum_copy(void *dst, const void *src, size_t len, uint32_t sum);
+uint16_t cksum_fold(uint32_t sum);
+uint16_t cksum(const void *buf, size_t len);
+uint16_t cksum_update16(uint16_t cksum, uint16_t old, uint16_t new);
+uint16_t cksum_update32(uint16_t cksum, uint32_t old, uint32_t new);
+
+/* net/core/cksum_arm.s */
+uint32_t cksum_words(const void *buf, size_t len, uint32_t sum);
+uint32_t cksum_copy_words(void *dst, const void *src, size_t len,
+	uint32_t sum);
+
+#endif /* ! _CORE_CKSUM_H */
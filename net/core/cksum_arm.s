@@ -0,0 +1,128 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2022, Eric Enright
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * net/core/cksum_arm.s
+ *
+ * Inner loops of the Internet checksum, see cksum.c.  Eight words are
+ * loaded per ldm and added with an adcs chain; the carry out of each block
+ * is folded back in at once, so the loop counter can use the flags.
+ */
+
+	.text
+	.code 32
+	.align 4
+
+	.global cksum_words
+	.func cksum_words
+	/*
+	 * Entry: r0: buf (word aligned), r1: len (multiple of 4), r2: sum
+	 *
+	 * Return: r0 is sum plus the words of buf, with end-around carry
+	 */
+cksum_words:
+	stmdb	sp!, {r4-r9,lr}
+	subs	r1, r1, #32
+	blt	.Lsum_words
+
+.Lsum_block:
+	ldmia	r0!, {r3-r9,ip}
+	adds	r2, r2, r3
+	adcs	r2, r2, r4
+	adcs	r2, r2, r5
+	adcs	r2, r2, r6
+	adcs	r2, r2, r7
+	adcs	r2, r2, r8
+	adcs	r2, r2, r9
+	adcs	r2, r2, ip
+	adc	r2, r2, #0
+	subs	r1, r1, #32
+	bge	.Lsum_block
+
+.Lsum_words:
+	adds	r1, r1, #(32 - 4)
+	blt	.Lsum_done
+.Lsum_word:
+	ldr	r3, [r0], #4
+	adds	r2, r2, r3
+	adc	r2, r2, #0
+	subs	r1, r1, #4
+	bge	.Lsum_word
+
+.Lsum_done:
+	mov	r0, r2
+	ldmia	sp!, {r4-r9,pc}
+	.endfunc
+
+
+	.global cksum_copy_words
+	.func cksum_copy_words
+	/*
+	 * Entry: r0: dst, r1: src (both word aligned), r2: len (multiple
+	 * of 4), r3: sum
+	 *
+	 * Return: r0 is sum plus the words copied, with end-around carry
+	 */
+cksum_copy_words:
+	stmdb	sp!, {r4-r9,lr}
+	subs	r2, r2, #32
+	blt	.Lcopy_words
+
+.Lcopy_block:
+	ldmia	r1!, {r4-r9,ip,lr}
+	stmia	r0!, {r4-r9,ip,lr}
+	adds	r3, r3, r4
+	adcs	r3, r3, r5
+	adcs	r3, r3, r6
+	adcs	r3, r3, r7
+	adcs	r3, r3, r8
+	adcs	r3, r3, r9
+	adcs	r3, r3, ip
+	adcs	r3, r3, lr
+	adc	r3, r3, #0
+	subs	r2, r2, #32
+	bge	.Lcopy_block
+
+.Lcopy_words:
+	adds	r2, r2, #(32 - 4)
+	blt	.Lcopy_done
+.Lcopy_word:
+	ldr	r4, [r1], #4
+	str	r4, [r0], #4
+	adds	r3, r3, r4
+	adc	r3, r3, #0
+	subs	r2, r2, #4
+	bge	.Lcopy_word
+
+.Lcopy_done:
+	mov	r0, r3
+	ldmia	sp!, {r4-r9,pc}
+	.endfunc
+
+	.end
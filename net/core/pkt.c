@@ -27,10 +27,37 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <sys/slab.h>
+
 #include "pkt.h"
 
-/* Number of bytes to pad the buffers to for checksum purposes */
-#define BUF_PADDING	4
+static struct kmem_cache *pkt_cache = NULL;
+
+/*---------------------------------------------------------------------
+ * pkt_init()
+ *
+ * 	This function creates the packet descriptor cache.  It must be
+ * 	called before any packets are allocated.
+ *
+ * Parameters:
+ *
+ * 	None
+ *
+ * Returns:
+ *
+ * 	0 on success
+ * 	-errno on error
+ */
+int pkt_init(void)
+{
+	pkt_cache = kmem_cache_create("en_net_pkt", sizeof(struct en_net_pkt),
+		0, NULL);
+	if (pkt_cache == NULL)
+		// @@@ return -ENOMEM;
+		return -1;
+
+	return 0;
+}
 
 /*---------------------------------------------------------------------
  * pkt_alloc()
@@ -51,17 +78,12 @@ struct en_net_pkt * pkt_alloc(size_t base)
 	struct en_net_pkt *pkt = NULL;
 
 	/* Allocate the base structure */
-	pkt = malloc(sizeof(struct en_net_pkt));
+	pkt = kmem_cache_alloc(pkt_cache);
 	if (pkt == NULL)
 		goto out_err;
 
 	memset(pkt, 0, sizeof(struct en_net_pkt));
 
-	/* Pad to an even size so we can cast the buffer as uint16_t
- 	 * for checksum purposes */
-	if (base % BUF_PADDING)
-		base += BUF_PADDING - (base % BUF_PADDING);
-
 	/* Allocate data buffer */
 	if (base > 0) {
 		pkt->data = malloc(base);
@@ -81,7 +103,7 @@ out_err:
 		if (pkt->data != NULL)
 			free(pkt->data);
 
-		free(pkt);
+		kmem_cache_free(pkt_cache, pkt);
 	}
 
 	return NULL;
@@ -105,7 +127,7 @@ void pkt_free(struct en_net_pkt *pkt)
 	if (pkt->data != NULL)
 		free(pkt->data);
 
-	free(pkt);
+	kmem_cache_free(pkt_cache, pkt);
 }
 
 /*---------------------------------------------------------------------
@@ -130,11 +152,6 @@ int pkt_grow(struct en_net_pkt *pkt, size_t len)
 	if (len <= 0 || len < pkt->allocated)
 		return 0;
 
-	/* Pad to an even size so we can cast the buffer as uint16_t
- 	 * for checksum purposes */
-	if (len % BUF_PADDING)
-		len += BUF_PADDING - (len % BUF_PADDING);
-
 	/* Allocate the new buffer */
 	p = malloc(len);
 	if (p == NULL)
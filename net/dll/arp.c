@@ -28,6 +28,11 @@
  */
 
 #include <sys/kernel.h>
+#include <sys/sched.h>
+#include <sys/slab.h>
+#include <sys/reclaim.h>
+#include <sys/irq.h>
+#include <syscall.h>
 #include <stdio.h>
 
 #include "eth.h"	/* @@@ en_ntohs */
@@ -39,6 +44,11 @@
 #define ARP_OP_REQUEST	1
 #define ARP_OP_REPLY	2
 
+/*
+ * Entries older than this are dropped when memory runs short
+ */
+#define ARP_CACHE_TTL	(300 * HZ)
+
 /* Source hardware address offset into data */
 #define ARP_SRC_HRD_OFFSET(arp) \
 	(0)
@@ -55,12 +65,23 @@
 #define ARP_DST_PROTO_OFFSET(arp) \
 	((arp->ar_hlen * 2) + arp->ar_plen)
 
+/*
+ * The cache is only touched with IRQs masked, as the reclaim hook runs
+ * from the timer interrupt
+ */
 struct list arp_cache_list = {
 	.next = NULL,
 	.prev = NULL
 };
 
-// @@@ static spinlock_t arp_cache_lock = SPIN_LOCK_UNLOCKED;
+static struct kmem_cache *arp_entry_cache = NULL;
+
+static int en_arp_cache_shrink(int urgent);
+
+static struct shrinker arp_shrinker = {
+	.name = "en_arp",
+	.shrink = en_arp_cache_shrink,
+};
 
 #if 0
 static void dump_arp(struct en_arp_pkt *arp)
@@ -70,10 +91,10 @@ static void dump_arp(struct en_arp_pkt *arp)
 
 	/* Print MAC src/dst */
 	i = ARP_SRC_HRD_OFFSET(arp);
-	printf("src %x:%x:%x:%x:%x:%x ",
+	printf("src %02x:%02x:%02x:%02x:%02x:%02x ",
 		p[i+0], p[i+1], p[i+2], p[i+3], p[i+4], p[i+5]);
 	i = ARP_DST_HRD_OFFSET(arp);
-	printf("dst %x:%x:%x:%x:%x:%x\r\n",
+	printf("dst %02x:%02x:%02x:%02x:%02x:%02x\r\n",
 		p[i+0], p[i+1], p[i+2], p[i+3], p[i+4], p[i+5]);
 
 	/* Print IP src/dst */
@@ -87,19 +108,21 @@ static void dump_arp(struct en_arp_pkt *arp)
 #endif
 
 /*---------------------------------------------------------------------
- * en_arp_cache_lookup()
+ * en_arp_cache_find()
  *
- * 	This function locates an ARP cache entry.
+ * 	This function locates an ARP cache entry.  It must be called with
+ * 	IRQs masked, which keeps the reclaim hook from freeing the entry
+ * 	while it is in use.
  *
  * Parameters:
  *
- * 	i_addr	- pointer to the IP address to lookup
+ * 	addr	- the IP address to look up
  *
  * Returns:
  *
  *	A pointer to the cache entry, or NULL if not found.
  */
-struct en_arp_entry * en_arp_cache_lookup(struct ip_addr *ip_addr)
+static struct en_arp_entry * en_arp_cache_find(uint32_t addr)
 {
 	struct list *p;
 	struct en_arp_entry *ep = NULL;
@@ -109,7 +132,7 @@ struct en_arp_entry * en_arp_cache_lookup(struct ip_addr *ip_addr)
 		ep = (struct en_arp_entry *)p;
 
 		/* Hit? */
-		if (ep->proto_addr.addr == ip_addr->addr) {
+		if (ep->proto_addr.addr == addr) {
 			/* Yes  */
 			return ep;
 		}
@@ -118,10 +141,81 @@ struct en_arp_entry * en_arp_cache_lookup(struct ip_addr *ip_addr)
 	return NULL;
 }
 
+/*---------------------------------------------------------------------
+ * en_arp_cache_lookup()
+ *
+ * 	This function looks up the MAC address for an IP address.  Entries
+ * 	may be freed at any time, so the address is copied out rather than
+ * 	returning the entry.
+ *
+ * Parameters:
+ *
+ * 	i_addr	- pointer to the IP address to lookup
+ * 	mac	- filled in with the MAC address on a hit
+ *
+ * Returns:
+ *
+ *	Zero on a hit, -1 if not found.
+ */
+int en_arp_cache_lookup(struct ip_addr *ip_addr, struct mac_addr *mac)
+{
+	struct en_arp_entry *ep;
+	uint32_t flags;
+	int rc = -1;
+
+	flags = irq_save();
+
+	ep = en_arp_cache_find(ip_addr->addr);
+	if (ep != NULL) {
+		memcpy(mac, &ep->hrd_addr, sizeof(*mac));
+		rc = 0;
+	}
+
+	irq_restore(flags);
+
+	return rc;
+}
+
+/*---------------------------------------------------------------------
+ * en_arp_cache_snapshot()
+ *
+ * 	This function copies out the ARP cache, for display.  Masking
+ * 	IRQs takes a privileged mode, so tasks go through
+ * 	SYS_ARP_SNAPSHOT.
+ *
+ * Parameters:
+ *
+ * 	buf	- entries are copied here; their list pointers are not valid
+ * 	n	- maximum number of entries to copy
+ *
+ * Returns:
+ *
+ *	The number of entries copied
+ */
+int en_arp_cache_snapshot(struct en_arp_entry *buf, int n)
+{
+	struct list *p;
+	uint32_t flags;
+	int i = 0;
+
+	if (self != kernel_self)
+		return __syscall2(SYS_ARP_SNAPSHOT, (uint32_t)buf, n);
+
+	flags = irq_save();
+
+	for (p = arp_cache_list.next; p != NULL && i < n; p = p->next)
+		memcpy(&buf[i++], p, sizeof(*buf));
+
+	irq_restore(flags);
+
+	return i;
+}
+
 /*---------------------------------------------------------------------
  * en_arp_cache_add()
  *
- * 	This function adds a new entry to the ARP cache.
+ * 	This function adds a new entry to the ARP cache.  It must be
+ * 	called with IRQs masked.
  *
  * Parameters:
  *
@@ -137,6 +231,76 @@ static void inline en_arp_cache_add(struct en_arp_entry *e)
 	list_add_after(&arp_cache_list, e);
 }
 
+/*---------------------------------------------------------------------
+ * en_arp_cache_shrink()
+ *
+ * 	This function ages the ARP cache under memory pressure.  Entries
+ * 	are simply looked up again when next needed.
+ *
+ * Parameters:
+ *
+ * 	urgent	- non-zero to drop every entry, not just stale ones
+ *
+ * Returns:
+ *
+ *	The number of entries freed
+ */
+static int en_arp_cache_shrink(int urgent)
+{
+	struct list *pp, *p;
+	struct en_arp_entry *ep;
+	int n = 0;
+
+	/*
+	 * Called with IRQs masked, from the timer tick or an allocation.
+	 * Everything else touches the cache with IRQs masked too and keeps
+	 * no pointer to an entry afterwards, so nothing is freed under it.
+	 */
+	for (pp = &arp_cache_list; (p = pp->next) != NULL; ) {
+		ep = (struct en_arp_entry *)p;
+
+		if (urgent || clkticks - ep->created > ARP_CACHE_TTL) {
+			pp->next = p->next;
+			if (p->next != NULL)
+				p->next->prev = pp;
+			kmem_cache_free(arp_entry_cache, ep);
+			++n;
+		} else {
+			pp = p;
+		}
+	}
+
+	return n;
+}
+
+/*---------------------------------------------------------------------
+ * en_arp_init()
+ *
+ * 	This function creates the ARP entry cache and registers it for
+ * 	reclaim.
+ *
+ * Parameters:
+ *
+ * 	None
+ *
+ * Returns:
+ *
+ * 	0 on success
+ * 	-errno on error
+ */
+int en_arp_init(void)
+{
+	arp_entry_cache = kmem_cache_create("en_arp_entry",
+		sizeof(struct en_arp_entry), 0, NULL);
+	if (arp_entry_cache == NULL)
+		// @@@ return -ENOMEM;
+		return -1;
+
+	register_shrinker(&arp_shrinker);
+
+	return 0;
+}
+
 // Request a MAC address
 int en_arp_request(struct en_eth_if *dev, uint32_t addr)
 {
@@ -290,6 +454,7 @@ static int en_arp_input_reply(struct en_net_pkt *pkt)
 	struct en_arp_pkt *arp = (struct en_arp_pkt *)pkt->data;
 	struct en_arp_entry *ep = NULL;
 	struct en_arp_entry e;
+	uint32_t flags;
 	int rc = 0;
 
 	memset(&e, 0, sizeof(e));
@@ -301,13 +466,17 @@ static int en_arp_input_reply(struct en_net_pkt *pkt)
 	//printf(__FILE__ ": received ARP reply:\n");
 	//dump_arp(arp);
 
-	// @@@ spin_lock_irq(&arp_cache_lock);
+	/*
+	 * Masked from the lookup to the add, so that the reclaim hook can not
+	 * run in between.  Allocating may reclaim, but nothing is held yet.
+	 */
+	flags = irq_save();
 
 	/* Does this pair exist in the cache? */
-	ep = en_arp_cache_lookup(&e.proto_addr);
+	ep = en_arp_cache_find(e.proto_addr.addr);
 	if (ep == NULL) {
 		/* No, add it */
-		ep = malloc(sizeof(struct en_arp_entry));
+		ep = kmem_cache_alloc(arp_entry_cache);
 		if (ep == NULL) {
 			// @@@ rc = -ENOMEM;
 			rc = -1;
@@ -317,7 +486,7 @@ static int en_arp_input_reply(struct en_net_pkt *pkt)
 		}
 	}
 
-	// @@@ spin_unlock_irq(&arp_cache_lock);
+	irq_restore(flags);
 
 	pkt_free(pkt);
 
@@ -59,8 +59,10 @@ struct en_arp_entry {
 
 struct list arp_cache_list;
 
+int en_arp_init(void);
 int en_arp_input(struct en_net_pkt *pkt);
-struct en_arp_entry * en_arp_cache_lookup(struct ip_addr *ip_addr);
+int en_arp_cache_lookup(struct ip_addr *ip_addr, struct mac_addr *mac);
+int en_arp_cache_snapshot(struct en_arp_entry *buf, int n);
 int en_arp_request(struct en_eth_if *dev, uint32_t addr);
 
 #define ARP_HRD_ETHERNET	1
@@ -330,6 +330,11 @@ int eth_init(void)
 {
 	struct proc *p;
 
+	if (pkt_init() || en_arp_init()) {
+		printf("eth_init: unable to create object caches\r\n");
+		return -1;
+	}
+
 	rx_completion.wait = bfifo_alloc(1);
 	if (rx_completion.wait == NULL) {
 		printf("eth_init: bfifo_alloc failed\r\n");
@@ -70,12 +70,16 @@ int en_icmp_input(struct en_net_pkt *pkt)
 	int rc = 0;
 	struct en_ip_hdr *ip = (struct en_ip_hdr *)pkt->data;
 	struct en_icmp_hdr *icmp = (struct en_icmp_hdr *)(((void *)ip) + ip->ihl * 4);
-	uint16_t sum;
+	uint16_t sum, old;
 	uint32_t dst;
 	int mustfree = 1;
 
-	/* Validate checksum */
-	sum = ocksum16(icmp, pkt->len - (ip->ihl * 4));
+	/* Validate checksum.  The IP header has been checked, so it adds
+	 * nothing to a sum taken at receive time. */
+	if (pkt->csum_valid)
+		sum = cksum_fold(pkt->csum);
+	else
+		sum = cksum_fold(cksum_partial(icmp, pkt->len - (ip->ihl * 4), 0));
 
 	if (sum != 0xffff) {
 		printf(__FILE__ ": dropped packet with bad cksum (%x sb %x)\r\n", icmp->cksum, sum);
@@ -92,11 +96,16 @@ int en_icmp_input(struct en_net_pkt *pkt)
 	switch (icmp->type) {
 	case ICMP_TYPE_ECHO:
 		dst = ip->src;
-		icmp->type = ICMP_TYPE_ECHO_REPLY;
 		icmp->id = en_htons(icmp->id);
 		icmp->seqnum = en_htons(icmp->seqnum);
-		sum = ocksum16(icmp, pkt->len - (ip->ihl * 4));
-		icmp->cksum = en_htons(sum);
+		icmp->cksum = en_htons(icmp->cksum);
+
+		/* Only the type changes, so patch the checksum for it rather
+		 * than summing the whole message again */
+		old = *(uint16_t *)icmp;	/* Type and code */
+		icmp->type = ICMP_TYPE_ECHO_REPLY;
+		icmp->cksum = cksum_update16(icmp->cksum, old,
+			*(uint16_t *)icmp);
 
 		// ip and icmp data pointers become invalid after this
 		pkt_del_head(pkt, sizeof(struct en_ip_hdr));
@@ -83,8 +83,7 @@ int en_ip_output(struct en_net_pkt *pkt, uint32_t dst)
 {
 	struct en_ip_hdr ip;
 	struct en_ip_route *rt = NULL;
-	struct en_arp_entry *arp;
-	uint16_t sum;
+	struct mac_addr mac;
 
 	// First things firt, we need a route
 	rt = en_ip_route_lookup(dst);
@@ -104,11 +103,9 @@ int en_ip_output(struct en_net_pkt *pkt, uint32_t dst)
 	memcpy(&ip.src,&((struct ip_desc *)rt->eth_if->ip_addrs.next)->addr, 4);
 	ip.src = en_htonl(ip.src);
 	ip.dst = en_htonl(dst);
-	sum = ocksum16(&ip, ip.ihl * 4);
-	ip.cksum = ~sum;	// invert
+	ip.cksum = cksum(&ip, ip.ihl * 4);
 
-	arp = en_arp_cache_lookup((struct ip_addr *)&dst);
-	if (arp == NULL) {
+	if (en_arp_cache_lookup((struct ip_addr *)&dst, &mac)) {
 		// Cache miss, request ARP lookup
 		en_arp_request(rt->eth_if, dst);
 
@@ -116,7 +113,7 @@ int en_ip_output(struct en_net_pkt *pkt, uint32_t dst)
 	} else {
 		// Good to go, output packet
 		pkt_add_head(pkt, &ip, sizeof(ip));
-		en_eth_output(rt->eth_if, pkt, &arp->hrd_addr, ETH_TYPE_IPV4);
+		en_eth_output(rt->eth_if, pkt, &mac, ETH_TYPE_IPV4);
 	}
 
 	return 0;
@@ -156,7 +153,7 @@ int en_ip_input(struct en_net_pkt *pkt)
 	}
 
 	/* Validate checksum */
-	sum = ocksum16(ip, ip->ihl * 4);
+	sum = cksum_fold(cksum_partial(ip, ip->ihl * 4, 0));
 
 	if (sum != 0xffff) {
 		printf(__FILE__ ": dropped packet with bad cksum (%x sb %x)\r\n", ip->cksum, sum);
@@ -178,8 +175,10 @@ int en_ip_input(struct en_net_pkt *pkt)
 	// If the pkt length is 46 (60 byte Ethernet minimum minus Ethernet
 	// header), then force the pkt len to be the IP len.  This is
 	// necessary because the Ethernet layer does not strip out padding.
-	if (pkt->len == 46 && ip->len < 46)
+	if (pkt->len == 46 && ip->len < 46) {
 		pkt->len = ip->len;
+		pkt->csum_valid = 0;	// Took in the padding
+	}
 
 	if (ip->ihl < 5 || ip->len != pkt->len) {
 		printf(__FILE__ ": dropped packet with invalid length\r\n");
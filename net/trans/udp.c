@@ -37,6 +37,7 @@
 #include "ip.h"
 
 #include <stdio.h>
+#include <string.h>
 
 // The UDP header
 struct en_udp_hdr {
@@ -58,29 +59,6 @@ struct en_udp_pseudo_hdr {
 	uint16_t	udp_len;
 } __attribute__((packed));
 
-// It would be nice to be able to use pkt.h's ocksum16, but we have two
-// buffers to check
-static inline uint16_t udp_ocksum16(void *buf1, size_t len1, void *buf2, size_t len2)
-{
-	uint16_t *p = (uint16_t *)buf1;
-	uint32_t sum = 0;
-
-	while (len1 > 0) {
-		sum += *p++;
-		len1 -= 2;
-	}
-
-	p = (uint16_t *)buf2;
-	while (len2 > 0) {
-		sum += *p++;
-		len2 -= 2;
-	}
-
-	sum = (sum & 0xffff) + (sum >> 16);
-
-	return (uint16_t)sum;
-}
-
 /*---------------------------------------------------------------------
  * en_udp_input()
  *
@@ -107,29 +85,39 @@ int en_udp_input(struct en_net_pkt *pkt)
 	struct en_ip_hdr *ip = (struct en_ip_hdr *)pkt->data;
 	struct en_udp_hdr *udp = (struct en_udp_hdr *)(((void *)ip) + ip->ihl * 4);
 
-#if 0
 	struct en_udp_pseudo_hdr pseudo;
-	uint16_t sum;
+	struct cksum_vec v[2];
+	uint32_t sum;
 
 	// Only validate checksum if non-zero
 	if (udp->cksum != 0) {
-		// Generate pseudo header
+		// Generate pseudo header.  The IP header is already in host
+		// byte order, the UDP header not yet.
 		memset(&pseudo, 0, sizeof(pseudo));
-		pseudo.src = ip->src;
-		pseudo.dst = ip->dst;
+		pseudo.src = en_htonl(ip->src);
+		pseudo.dst = en_htonl(ip->dst);
 		pseudo.proto = ip->proto;
 		pseudo.udp_len = udp->len;
 
-		sum = udp_ocksum16(&pseudo, sizeof(pseudo), udp, ip->len - (ip->ihl * 4));
-
-		if (sum != udp->cksum) {
-			printf("en_udp_input: dropped packet with bad checksum: is 0x%x s/b 0x%x\r\n",
-				sum, udp->cksum);
+		// A sum taken at receive time covers the IP header too, which
+		// adds nothing as it has been checked
+		if (pkt->csum_valid) {
+			sum = cksum_partial(&pseudo, sizeof(pseudo), pkt->csum);
 		} else {
-			printf("good\r\n");
+			v[0].buf = &pseudo;
+			v[0].len = sizeof(pseudo);
+			v[1].buf = udp;
+			v[1].len = ip->len - (ip->ihl * 4);
+			sum = cksum_vec(v, 2, 0);
+		}
+
+		if (cksum_fold(sum) != 0xffff) {
+			printf("en_udp_input: dropped packet with bad checksum: 0x%x\r\n",
+				udp->cksum);
+			rc = -1;
+			goto out;
 		}
 	}
-#endif
 
 	// Convert to host byte order
 	udp->port.src = en_ntohs(udp->port.src);
@@ -0,0 +1,928 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2022, Eric Enright
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * user/bench.c
+ *
+ * Micro-benchmark suite.  Each benchmark times a batch of operations with
+ * the debug timer and prints one line per result in the form
+ *
+ *	bench <name> size=<bytes> n=<ops> us=<total> <metric>=<value>
+ *
+ * (size only where it applies) so that runs can be captured from the
+ * console and compared by script.  Interrupts are left enabled, so results
+ * include the cost of the 100Hz tick and anything else going on; run them
+ * on an otherwise idle system.
+ */
+
+#include "../config.h"
+
+#include <sys/proc.h>
+#include <sys/sched.h>
+#include <sys/kernel.h>
+#include <sys/timers.h>
+#include <sys/uart.h>
+#include <sys/mem.h>
+
+#include <types.h>
+#include <stdio.h>
+#include <string.h>
+#include <sleep.h>
+#include <cons.h>
+#include <heap.h>
+#include <div.h>
+#include <crc.h>
+
+#ifdef CONFIG_NAND
+#	include <nand.h>
+#	include "../dev/hamming.h"
+#endif
+
+#ifdef CONFIG_NET
+#	include "../net/core/pkt.h"
+#endif
+
+#include "../arch/regs.h"
+#include "bench.h"
+
+#define BENCH_BUF_SIZE	8192
+
+// arch/init.c
+extern struct uart uart1;
+
+static void bench_report(const char *name, int size, int n, uint32_t ticks,
+	const char *metric, uint32_t value)
+{
+	printf("bench %s ", name);
+	if (size > 0)
+		printf("size=%d ", size);
+	printf("n=%d us=%d %s=%d\r\n", n, debug_timer_to_us(ticks), metric, value);
+}
+
+// Report the time per operation in nanoseconds
+static void bench_report_op(const char *name, int size, int n, uint32_t ticks)
+{
+	uint32_t us = debug_timer_to_us(ticks);
+
+	if (n == 0)
+		n = 1;
+
+	bench_report(name, size, n, ticks, "ns_per_op", (us * 1000) / n);
+}
+
+// Report throughput in kB/s
+static void bench_report_bw(const char *name, int size, int n, uint32_t ticks,
+	uint32_t bytes)
+{
+	uint32_t us = debug_timer_to_us(ticks);
+
+	if (us == 0)
+		us = 1;
+
+	bench_report(name, size, n, ticks, "kB_per_s",
+		(bytes / us) * 1000 + ((bytes % us) * 1000) / us);
+}
+
+// Run call n times with i counting up from 0, and leave the debug timer
+// ticks taken in ticks
+#define BENCH_TIME(ticks, i, n, call) do {				\
+	uint32_t bench_start = debug_timer_read();			\
+	for ((i) = 0; (i) < (n); ++(i))					\
+		call;							\
+	(ticks) = debug_timer_read() - bench_start;			\
+} while (0)
+
+/*
+ * Context switch
+ *
+ * A helper task and the benchmark task both spin stamping the debug timer.
+ * When the benchmark task finds a gap in its own stamps it was switched
+ * out; the distance from the helper's last stamp to now is the cost of the
+ * tick, the scheduler and both halves of the switch.
+ */
+
+#define BENCH_SWITCHES	50
+#define BENCH_EV_CS	0x00000001
+
+static volatile uint32_t bench_cs_stamp;
+static volatile int bench_cs_run;
+static struct proc *bench_cs_task;
+
+static void bench_cs_helper(void)
+{
+	while (1) {
+		event_wait(BENCH_EV_CS);
+
+		while (bench_cs_run)
+			bench_cs_stamp = debug_timer_read();
+	}
+}
+
+static void bench_switch(void)
+{
+	uint32_t t, last, gap;
+	uint32_t total = 0, worst = 0;
+	int n = 0;
+
+	if (bench_cs_task == NULL) {
+		bench_cs_task = spawn(bench_cs_helper, "bench", PROC_USER);
+		if (bench_cs_task == NULL) {
+			printf("bench: unable to spawn helper\r\n");
+			return;
+		}
+
+		// Let it reach event_wait()
+		sleep(20);
+	}
+
+	bench_cs_stamp = debug_timer_read();
+	bench_cs_run = 1;
+	event_set(BENCH_EV_CS);
+
+	last = debug_timer_read();
+	while (n < BENCH_SWITCHES) {
+		t = debug_timer_read();
+
+		// Anything over 50us means we were switched out.  Only count it
+		// if the helper ran in the meantime.
+		if (t - last > 50 && bench_cs_stamp - last < t - last) {
+			gap = t - bench_cs_stamp;
+			total += gap;
+			if (gap > worst)
+				worst = gap;
+			++n;
+		}
+
+		last = t;
+	}
+
+	bench_cs_run = 0;
+
+	bench_report_op("switch", 0, n, total);
+	bench_report("switch_worst", 0, 1, worst, "us", debug_timer_to_us(worst));
+}
+
+#define BENCH_SYSCALLS	1000
+
+// event_set() on an empty mask walks the process list and returns without
+// rescheduling, making it the cheapest round trip into the kernel
+static void bench_syscall(void)
+{
+	uint32_t start;
+	int i;
+
+	start = debug_timer_read();
+	for (i = 0; i < BENCH_SYSCALLS; ++i)
+		event_set(0);
+	bench_report_op("syscall", 0, BENCH_SYSCALLS,
+		debug_timer_read() - start);
+}
+
+#define BENCH_ALLOCS	1000
+
+static const int bench_alloc_sizes[] = { 16, 100, 1000, 4000 };
+
+// Allocations held at once when timing malloc() and free() apart, so that
+// neither just recycles the chunk the other handed back
+#define BENCH_ALLOC_BATCH	32
+
+#define BENCH_EV_MALLOC	0x00000002
+
+// The same sizes as literals, so malloc() resolves the class at compile
+// time.  Compare against malloc_free to see the saving per call.
+#define BENCH_MALLOC_CONST(size) do {					\
+	BENCH_TIME(t, i, BENCH_ALLOCS, free(malloc(size)));		\
+	bench_report_op("malloc_const", size, BENCH_ALLOCS, t);		\
+} while (0)
+
+static volatile int bench_malloc_done;
+static struct proc *bench_malloc_task;
+
+// The kernel allocator masks IRQs around its free lists, which only works
+// from a privileged mode, so it is timed from a system task rather than
+// the console
+static void bench_malloc_helper(void)
+{
+	void *p[BENCH_ALLOC_BATCH];
+	uint32_t t;
+	int i, j, size;
+
+	while (1) {
+		event_wait(BENCH_EV_MALLOC);
+
+		BENCH_MALLOC_CONST(16);
+		BENCH_MALLOC_CONST(100);
+		BENCH_MALLOC_CONST(1000);
+		BENCH_MALLOC_CONST(4000);
+
+		for (j = 0; j < sizeof(bench_alloc_sizes) / sizeof(int); ++j) {
+			size = bench_alloc_sizes[j];
+
+			BENCH_TIME(t, i, BENCH_ALLOCS, free(malloc(size)));
+			bench_report_op("malloc_free", size, BENCH_ALLOCS, t);
+
+			BENCH_TIME(t, i, BENCH_ALLOC_BATCH, p[i] = malloc(size));
+			bench_report_op("malloc", size, BENCH_ALLOC_BATCH, t);
+
+			BENCH_TIME(t, i, BENCH_ALLOC_BATCH, free(p[i]));
+			bench_report_op("free", size, BENCH_ALLOC_BATCH, t);
+		}
+
+		bench_malloc_done = 1;
+	}
+}
+
+// The task's own heap here, then the kernel allocator from the helper
+static void bench_malloc(void)
+{
+	void *p[BENCH_ALLOC_BATCH];
+	uint32_t t;
+	int i, j, size;
+
+	for (j = 0; j < sizeof(bench_alloc_sizes) / sizeof(int); ++j) {
+		size = bench_alloc_sizes[j];
+
+		BENCH_TIME(t, i, BENCH_ALLOCS, ufree(umalloc(size)));
+		bench_report_op("umalloc_ufree", size, BENCH_ALLOCS, t);
+
+		BENCH_TIME(t, i, BENCH_ALLOC_BATCH, p[i] = umalloc(size));
+		bench_report_op("umalloc", size, BENCH_ALLOC_BATCH, t);
+
+		BENCH_TIME(t, i, BENCH_ALLOC_BATCH, ufree(p[i]));
+		bench_report_op("ufree", size, BENCH_ALLOC_BATCH, t);
+	}
+
+	if (bench_malloc_task == NULL) {
+		bench_malloc_task = spawn(bench_malloc_helper, "bench_malloc",
+			PROC_SYSTEM);
+		if (bench_malloc_task == NULL) {
+			printf("bench: unable to spawn helper\r\n");
+			return;
+		}
+
+		// Let it reach event_wait()
+		sleep(20);
+	}
+
+	bench_malloc_done = 0;
+	event_set(BENCH_EV_MALLOC);
+	while (!bench_malloc_done)
+		sleep(10);
+}
+
+#define BENCH_DIVS	1000
+
+// The bit-serial divide that was in lib/math.c, as a baseline
+static uint32_t bench_div_serial(uint32_t num, uint32_t den)
+{
+	uint32_t bit = 1;
+	uint32_t res = 0;
+
+	while (den < num && bit && !(den & (1 << 31))) {
+		den <<= 1;
+		bit <<= 1;
+	}
+	while (bit) {
+		if (num >= den) {
+			num -= den;
+			res |= bit;
+		}
+		bit >>= 1;
+		den >>= 1;
+	}
+
+	return res;
+}
+
+// Time call, which may use the loop counter i.  Results are summed into a
+// volatile so that none of the calls can be dropped.
+#define BENCH_DIV(name, call) do {					\
+	uint32_t sum = 0;						\
+	BENCH_TIME(t, i, BENCH_DIVS, sum += call);			\
+	bench_report_op(name, 0, BENCH_DIVS, t);			\
+	bench_div_sink = sum;						\
+} while (0)
+
+// Read through a volatile so that the compiler cannot see the divisor
+static volatile uint32_t bench_div_den = 10;
+static volatile uint32_t bench_div_sink;
+
+static void bench_div(void)
+{
+	uint32_t num = 123456789;
+	uint32_t den = bench_div_den;
+	uint32_t t;
+	int i;
+
+	BENCH_DIV("div_serial", bench_div_serial(num + i, den));
+	BENCH_DIV("div", (num + i) / den);
+	BENCH_DIV("div_small", (uint32_t)i / den);
+	BENCH_DIV("mod", (num + i) % den);
+	BENCH_DIV("sdiv", -(int)(num + i) / (int)den);
+	BENCH_DIV("udiv10", udiv10(num + i));
+	BENCH_DIV("udiv100", udiv100(num + i));
+}
+
+// Bytes moved per size in the memory benchmarks
+#define BENCH_MEM_BYTES	(256 * 1024)
+
+static const int bench_mem_sizes[] = { 16, 64, 1024, BENCH_BUF_SIZE };
+
+// Time call, made BENCH_MEM_BYTES / size times with i counting them.
+// Names carry the destination and source offsets from a word boundary.
+#define BENCH_MEM(name, size, call) do {				\
+	BENCH_TIME(t, i, BENCH_MEM_BYTES / (size), call);		\
+	bench_report_bw(name, size, BENCH_MEM_BYTES / (size), t,	\
+		BENCH_MEM_BYTES);					\
+} while (0)
+
+static void bench_mem(void)
+{
+	char *src, *dst;
+	uint32_t t;
+	int i, j, size;
+
+	// Room for the misaligned runs
+	src = umalloc(BENCH_BUF_SIZE + 4);
+	dst = umalloc(BENCH_BUF_SIZE + 4);
+	if (src == NULL || dst == NULL) {
+		printf("bench: unable to allocate buffers\r\n");
+		goto out;
+	}
+
+	memset(src, 0x5a, BENCH_BUF_SIZE);
+
+	for (j = 0; j < sizeof(bench_mem_sizes) / sizeof(int); ++j) {
+		size = bench_mem_sizes[j];
+
+		BENCH_MEM("memcpy", size, memcpy(dst, src, size));
+		BENCH_MEM("memcpy_11", size, memcpy(dst + 1, src + 1, size));
+		BENCH_MEM("memcpy_03", size, memcpy(dst, src + 3, size));
+		BENCH_MEM("memmove_20", size, memmove(src + 2, src, size));
+		BENCH_MEM("memset", size, memset(dst, i, size));
+		BENCH_MEM("memset_1", size, memset(dst + 1, i, size));
+	}
+
+	memset(src, 'x', BENCH_BUF_SIZE);
+	src[BENCH_BUF_SIZE - 1] = '\0';
+	BENCH_MEM("strlen", BENCH_BUF_SIZE, strlen(src));
+
+out:
+
+	if (src != NULL)
+		ufree(src);
+	if (dst != NULL)
+		ufree(dst);
+}
+
+/*
+ * Check memcpy(), memmove(), memset() and strlen() against byte loops for
+ * every length up to BENCH_CHECK_LEN at every alignment, and memmove()
+ * overlapping either way.  The rest of the buffer is compared too, to
+ * catch overruns.  Reports the number of cases which failed.
+ */
+#define BENCH_CHECK_LEN	80
+#define BENCH_CHECK_BUF	(2 * BENCH_CHECK_LEN + 16)
+#define BENCH_CHECK_SRC	(BENCH_CHECK_LEN + 8)	// Source offset in buf
+
+static void bench_check_fill(char *buf, char *ref, int seed)
+{
+	int i;
+
+	// Never zero, so strlen() can be checked on it
+	for (i = 0; i < BENCH_CHECK_BUF; ++i)
+		buf[i] = ref[i] = (i * 7 + seed) | 1;
+}
+
+static int bench_check_cmp(const char *buf, const char *ref)
+{
+	int i;
+
+	for (i = 0; i < BENCH_CHECK_BUF; ++i)
+		if (buf[i] != ref[i])
+			return 1;
+
+	return 0;
+}
+
+// Byte at a time reference copy, safe for any overlap
+static void bench_check_move(char *dst, const char *src, int n)
+{
+	int i;
+
+	if (dst < src)
+		for (i = 0; i < n; ++i)
+			dst[i] = src[i];
+	else
+		for (i = n - 1; i >= 0; --i)
+			dst[i] = src[i];
+}
+
+static void bench_memcheck(void)
+{
+	char *buf, *ref, *dst, *src;
+	int n, d, s, i, off, cases = 0, errors = 0;
+	uint32_t start;
+
+	buf = umalloc(BENCH_CHECK_BUF);
+	ref = umalloc(BENCH_CHECK_BUF);
+	if (buf == NULL || ref == NULL) {
+		printf("bench: unable to allocate buffers\r\n");
+		goto out;
+	}
+
+	start = debug_timer_read();
+
+	for (n = 0; n <= BENCH_CHECK_LEN; ++n) {
+		for (d = 0; d < 4; ++d) {
+			dst = buf + 4 + d;
+
+			for (s = 0; s < 4; ++s) {
+				src = buf + BENCH_CHECK_SRC + s;
+
+				bench_check_fill(buf, ref, n + s);
+				bench_check_move(ref + (dst - buf),
+					ref + (src - buf), n);
+				if (memcpy(dst, src, n) != dst
+						|| bench_check_cmp(buf, ref))
+					++errors;
+				++cases;
+
+				// Overlapping, with src at 4 + s
+				for (off = -4; off <= 4; ++off) {
+					src = buf + 4 + s;
+					dst = src + off + d;
+
+					bench_check_fill(buf, ref, n + off);
+					bench_check_move(ref + (dst - buf),
+						ref + (src - buf), n);
+					if (memmove(dst, src, n) != dst
+							|| bench_check_cmp(buf, ref))
+						++errors;
+					++cases;
+				}
+
+				dst = buf + 4 + d;
+			}
+
+			bench_check_fill(buf, ref, n + d);
+			for (i = 0; i < n; ++i)
+				ref[4 + d + i] = 0xa5;
+			if (memset(dst, 0x1a5, n) != dst
+					|| bench_check_cmp(buf, ref))
+				++errors;
+			++cases;
+
+			dst[n] = '\0';
+			if (strlen(dst) != n)
+				++errors;
+			++cases;
+		}
+	}
+
+	bench_report("memcheck", 0, cases, debug_timer_read() - start,
+		"errors", errors);
+
+out:
+
+	if (buf != NULL)
+		ufree(buf);
+	if (ref != NULL)
+		ufree(ref);
+}
+
+#ifdef CONFIG_NET
+#define BENCH_CKSUMS	200
+#define BENCH_CKSUM_LEN	1500
+
+static void bench_cksum(void)
+{
+	char *buf, *dst;
+	uint32_t start;
+	int i;
+
+	// Room for the odd-aligned run
+	buf = umalloc(BENCH_CKSUM_LEN + 1);
+	dst = umalloc(BENCH_CKSUM_LEN);
+	if (buf == NULL || dst == NULL) {
+		printf("bench: unable to allocate buffers\r\n");
+		goto out;
+	}
+
+	for (i = 0; i < BENCH_CKSUM_LEN + 1; ++i)
+		buf[i] = i;
+
+	start = debug_timer_read();
+	for (i = 0; i < BENCH_CKSUMS; ++i)
+		cksum(buf, BENCH_CKSUM_LEN);
+	bench_report_bw("cksum", BENCH_CKSUM_LEN, BENCH_CKSUMS,
+		debug_timer_read() - start, BENCH_CKSUMS * BENCH_CKSUM_LEN);
+
+	start = debug_timer_read();
+	for (i = 0; i < BENCH_CKSUMS; ++i)
+		cksum(buf + 1, BENCH_CKSUM_LEN);
+	bench_report_bw("cksum_odd", BENCH_CKSUM_LEN, BENCH_CKSUMS,
+		debug_timer_read() - start, BENCH_CKSUMS * BENCH_CKSUM_LEN);
+
+	// Against the two passes it replaces
+	start = debug_timer_read();
+	for (i = 0; i < BENCH_CKSUMS; ++i)
+		cksum_copy(dst, buf, BENCH_CKSUM_LEN, 0);
+	bench_report_bw("cksum_copy", BENCH_CKSUM_LEN, BENCH_CKSUMS,
+		debug_timer_read() - start, BENCH_CKSUMS * BENCH_CKSUM_LEN);
+
+	start = debug_timer_read();
+	for (i = 0; i < BENCH_CKSUMS; ++i) {
+		memcpy(dst, buf, BENCH_CKSUM_LEN);
+		cksum(dst, BENCH_CKSUM_LEN);
+	}
+	bench_report_bw("memcpy_cksum", BENCH_CKSUM_LEN, BENCH_CKSUMS,
+		debug_timer_read() - start, BENCH_CKSUMS * BENCH_CKSUM_LEN);
+
+out:
+
+	if (buf != NULL)
+		ufree(buf);
+	if (dst != NULL)
+		ufree(dst);
+}
+#endif // CONFIG_NET
+
+#define BENCH_CRCS	50
+#define BENCH_CRC_LEN	2048
+
+// A bit per step, as the CRCs in dev/usb.c were, as a baseline
+static uint32_t bench_crc32_serial(uint32_t crc, const uint8_t *p, size_t len)
+{
+	int i;
+
+	crc = ~crc;
+	while (len--) {
+		crc ^= *p++;
+		for (i = 0; i < 8; ++i)
+			crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+	}
+
+	return ~crc;
+}
+
+// Time call over the buffer, made BENCH_CRCS times
+#define BENCH_CRC(name, call) do {					\
+	BENCH_TIME(t, i, BENCH_CRCS, call);				\
+	bench_report_bw(name, BENCH_CRC_LEN, BENCH_CRCS, t,		\
+		BENCH_CRCS * BENCH_CRC_LEN);				\
+} while (0)
+
+static void bench_crc(void)
+{
+	uint8_t *buf;
+	uint32_t crc, t;
+	int i, errors = 0;
+
+	// Room for the odd-aligned run
+	buf = umalloc(BENCH_CRC_LEN + 1);
+	if (buf == NULL) {
+		printf("bench: unable to allocate buffer\r\n");
+		return;
+	}
+
+	for (i = 0; i < BENCH_CRC_LEN + 1; ++i)
+		buf[i] = i * 7;
+
+	BENCH_CRC("crc32_serial", bench_crc32_serial(0, buf, BENCH_CRC_LEN));
+	BENCH_CRC("crc32_byte", crc32_byte(0, buf, BENCH_CRC_LEN));
+	BENCH_CRC("crc32", crc32(0, buf, BENCH_CRC_LEN));
+	BENCH_CRC("crc32_odd", crc32(0, buf + 1, BENCH_CRC_LEN));
+	BENCH_CRC("crc16_usb", crc16_usb(0, buf, BENCH_CRC_LEN));
+
+	// All three must agree, including when run in pieces
+	for (i = 0; i < 64; ++i) {
+		crc = bench_crc32_serial(0, buf + (i & 3), BENCH_CRC_LEN - i);
+		if (crc32_byte(0, buf + (i & 3), BENCH_CRC_LEN - i) != crc)
+			++errors;
+		if (crc32(crc32(0, buf + (i & 3), i),
+				buf + (i & 3) + i, BENCH_CRC_LEN - 2 * i) != crc)
+			++errors;
+	}
+	if (crc32(0, "123456789", 9) != 0xcbf43926
+			|| crc16_usb(0, "123456789", 9) != 0xb4c8
+			|| crc5_usb(0x547, 11) != 0x17)
+		++errors;
+
+	bench_report("crc_check", 0, 64, 0, "errors", errors);
+
+	ufree(buf);
+}
+
+#ifdef CONFIG_NAND
+#define BENCH_PAGES	16
+
+// The byte at a time code that was in dev/hamming.c (from NetBSD), as a
+// baseline and to check against
+static void bench_hamming_ref(const uint8_t *data, uint8_t *code)
+{
+	uint8_t column_sum = 0, even_line = 0, odd_line = 0;
+	uint8_t even_column = 0, odd_column = 0;
+	uint8_t b;
+	int i, j, parity;
+
+	for (i = 0; i < 256; ++i) {
+		column_sum ^= data[i];
+
+		parity = 0;
+		for (b = data[i]; b != 0; b >>= 1)
+			parity ^= b & 1;
+		if (parity) {
+			even_line ^= 255 - i;
+			odd_line ^= i;
+		}
+	}
+
+	for (i = 0; i < 8; ++i) {
+		if (column_sum & (1 << i)) {
+			even_column ^= 7 - i;
+			odd_column ^= i;
+		}
+	}
+
+	code[0] = code[1] = code[2] = 0;
+	for (i = 0; i < 4; ++i) {
+		j = 7 - i;
+		code[0] = code[0] << 2 | ((odd_line >> j) & 1) << 1
+			| ((even_line >> j) & 1);
+		j = 3 - i;
+		code[1] = code[1] << 2 | ((odd_line >> j) & 1) << 1
+			| ((even_line >> j) & 1);
+		j = 2 - i;
+		if (j >= 0)
+			code[2] = code[2] << 2 | ((odd_column >> j) & 1) << 1
+				| ((even_column >> j) & 1);
+		else
+			code[2] <<= 2;
+	}
+
+	code[0] = ~code[0];
+	code[1] = ~code[1];
+	code[2] = ~code[2];
+}
+
+static int bench_hamming_differ(const uint8_t *a, const uint8_t *b)
+{
+	return a[0] != b[0] || a[1] != b[1] || a[2] != b[2];
+}
+
+static void bench_hamming(void)
+{
+	uint8_t *buf;
+	uint8_t ecc[HAMMING_PAGE_BLOCKS * 3], ref[3];
+	uint32_t start, seed = 1;
+	int i, j, cases = 0, errors = 0;
+
+	// Room for the odd-aligned run
+	buf = umalloc(NAND_PAGE_SIZE + 1);
+	if (buf == NULL) {
+		printf("bench: unable to allocate buffer\r\n");
+		return;
+	}
+
+	for (i = 0; i < NAND_PAGE_SIZE + 1; ++i)
+		buf[i] = i * 7;
+
+	start = debug_timer_read();
+	for (i = 0; i < BENCH_PAGES; ++i)
+		for (j = 0; j < HAMMING_PAGE_BLOCKS; ++j)
+			bench_hamming_ref(buf + j * 256, ecc);
+	bench_report_bw("hamming_ref", NAND_PAGE_SIZE, BENCH_PAGES,
+		debug_timer_read() - start, BENCH_PAGES * NAND_PAGE_SIZE);
+
+	start = debug_timer_read();
+	for (i = 0; i < BENCH_PAGES; ++i)
+		for (j = 0; j < HAMMING_PAGE_BLOCKS; ++j)
+			hamming_compute_256(buf + j * 256, ecc);
+	bench_report_bw("hamming", NAND_PAGE_SIZE, BENCH_PAGES,
+		debug_timer_read() - start, BENCH_PAGES * NAND_PAGE_SIZE);
+
+	start = debug_timer_read();
+	for (i = 0; i < BENCH_PAGES; ++i)
+		hamming_compute_page(buf, HAMMING_PAGE_BLOCKS, ecc);
+	bench_report_bw("hamming_page", NAND_PAGE_SIZE, BENCH_PAGES,
+		debug_timer_read() - start, BENCH_PAGES * NAND_PAGE_SIZE);
+
+	start = debug_timer_read();
+	for (i = 0; i < BENCH_PAGES; ++i)
+		hamming_compute_page(buf + 1, HAMMING_PAGE_BLOCKS, ecc);
+	bench_report_bw("hamming_page_odd", NAND_PAGE_SIZE, BENCH_PAGES,
+		debug_timer_read() - start, BENCH_PAGES * NAND_PAGE_SIZE);
+
+	// Against the reference on sparse and dense data, then correct a
+	// flipped bit in each block
+	for (i = 0; i < BENCH_PAGES; ++i) {
+		for (j = 0; j < NAND_PAGE_SIZE; ++j) {
+			seed = seed * 1103515245 + 12345;
+			buf[j] = (i & 1) ? seed >> 16 : (seed >> 24 == 0);
+		}
+
+		hamming_compute_page(buf, HAMMING_PAGE_BLOCKS, ecc);
+		for (j = 0; j < HAMMING_PAGE_BLOCKS; ++j) {
+			bench_hamming_ref(buf + j * 256, ref);
+			if (bench_hamming_differ(ref, ecc + j * 3))
+				++errors;
+
+			buf[j * 256 + (seed & 0xff)] ^= 1 << (i & 7);
+			hamming_compute_256(buf + j * 256, ref);
+			if (hamming_correct_256(buf + j * 256, ecc + j * 3, ref)
+					!= HAMMING_ERROR_SINGLEBIT)
+				++errors;
+			hamming_compute_256(buf + j * 256, ref);
+			if (bench_hamming_differ(ref, ecc + j * 3))
+				++errors;
+			cases += 3;
+		}
+	}
+
+	bench_report("hamming_check", 0, cases, 0, "errors", errors);
+
+	ufree(buf);
+}
+
+static void bench_nand(void)
+{
+	char *buf;
+	uint32_t start;
+	int i;
+
+	buf = umalloc(NAND_RAW_PAGE_SIZE);
+	if (buf == NULL) {
+		printf("bench: unable to allocate buffer\r\n");
+		return;
+	}
+
+	start = debug_timer_read();
+	for (i = 0; i < BENCH_PAGES; ++i)
+		nand_read_page(i, buf);
+	bench_report_bw("nand_read_page", NAND_PAGE_SIZE, BENCH_PAGES,
+		debug_timer_read() - start, BENCH_PAGES * NAND_PAGE_SIZE);
+
+	ufree(buf);
+}
+#endif // CONFIG_NAND
+
+#define BENCH_FORMATS	200
+
+// Format a typical log line into a buffer, without the console cost
+static void bench_snprintf(void)
+{
+	char buf[80];
+	uint32_t start;
+	int i;
+
+	start = debug_timer_read();
+	for (i = 0; i < BENCH_FORMATS; ++i)
+		snprintf(buf, sizeof(buf), "%s: pid %d at 0x%08x, %u bytes\r\n",
+			"bench", i, (uint32_t)buf + i, 1234567 + i);
+	bench_report_op("snprintf", 0, BENCH_FORMATS,
+		debug_timer_read() - start);
+}
+
+#define BENCH_UART_BYTES	2048
+
+// Time a burst of spaces through the console until the UART has sent the
+// last of them
+static void bench_uart(void)
+{
+	char buf[64];
+	uint32_t start;
+	int i;
+
+	memset(buf, ' ', sizeof(buf));
+
+	flush();
+
+	start = debug_timer_read();
+	for (i = 0; i < BENCH_UART_BYTES; i += sizeof(buf))
+		cons_write(buf, sizeof(buf));
+
+	while (uart_fifo_available(&uart1.tx_fifo) > 0
+		|| !(inl(UART1Flag) & TXFE))
+		;
+	start = debug_timer_read() - start;
+
+	putchar('\r');
+	bench_report_bw("uart_tx", 0, BENCH_UART_BYTES, start,
+		BENCH_UART_BYTES);
+}
+
+#define BENCH_TICKS	100
+
+// Sample the debug timer on each timer tick and report how far the period
+// strays from the nominal 1/HZ
+static void bench_jitter(void)
+{
+	uint32_t t, last, period, dev;
+	uint32_t worst = 0, total = 0;
+	uint32_t tick;
+	int i;
+
+	period = DEBUG_TIMER_HZ / HZ;
+
+	// Line up with a tick edge
+	tick = clkticks;
+	while (*(volatile uint32_t *)&clkticks == tick)
+		;
+	last = debug_timer_read();
+
+	for (i = 0; i < BENCH_TICKS; ++i) {
+		tick = clkticks;
+		while (*(volatile uint32_t *)&clkticks == tick)
+			;
+		t = debug_timer_read();
+
+		dev = t - last > period ? t - last - period : period - (t - last);
+		total += dev;
+		if (dev > worst)
+			worst = dev;
+
+		last = t;
+	}
+
+	bench_report("timer_jitter_avg", 0, BENCH_TICKS, total, "us",
+		debug_timer_to_us(total) / BENCH_TICKS);
+	bench_report("timer_jitter_worst", 0, BENCH_TICKS, worst, "us",
+		debug_timer_to_us(worst));
+}
+
+struct bench {
+	const char *name;
+	void (*func)(void);
+};
+
+static struct bench benches[] = {
+#ifdef CONFIG_NET
+	{ "cksum", bench_cksum },
+#endif
+	{ "crc", bench_crc },
+	{ "div", bench_div },
+#ifdef CONFIG_NAND
+	{ "hamming", bench_hamming },
+#endif
+	{ "jitter", bench_jitter },
+	{ "malloc", bench_malloc },
+	{ "mem", bench_mem },
+	{ "memcheck", bench_memcheck },
+#ifdef CONFIG_NAND
+	{ "nand", bench_nand },
+#endif
+	{ "snprintf", bench_snprintf },
+	{ "switch", bench_switch },
+	{ "syscall", bench_syscall },
+	{ "uart", bench_uart },
+	{ NULL, NULL }
+};
+
+int bench_run(const char *name)
+{
+	int i, found = 0;
+
+	for (i = 0; benches[i].name != NULL; ++i) {
+		if (name == NULL || !strcmp(name, benches[i].name)) {
+			benches[i].func();
+			found = 1;
+		}
+	}
+
+	return found ? 0 : -1;
+}
+
+void bench_list(void)
+{
+	int i;
+
+	for (i = 0; benches[i].name != NULL; ++i)
+		printf("\t%s\r\n", benches[i].name);
+}
@@ -40,12 +40,15 @@
 #include <sys/proc.h>
 #include <sys/sched.h>
 #include <sys/kernel.h>
+#include <sys/uart.h>
+#include <sys/timers.h>
 
 #include <stdio.h>
 #include <sleep.h>
 #include <cons.h>
 #include <string.h>
 #include <kstat.h>
+#include <heap.h>
 
 #ifdef CONFIG_NAND
 #	include <nand.h>
@@ -66,6 +69,29 @@
 #	include "../net/dll/arp.h"
 #endif
 
+#ifdef CONFIG_TRACE
+#	include <sys/trace.h>
+#endif
+
+#ifdef CONFIG_PROF
+#	include <sys/prof.h>
+#endif
+
+#ifdef CONFIG_IRQSTAT
+#	include <sys/irq.h>
+#endif
+
+#ifdef CONFIG_BENCH
+#	include "bench.h"
+#endif
+
+#ifdef CONFIG_MEMSTAT
+#	include <sys/memstat.h>
+#endif
+
+// arch/init.c
+extern struct uart uart1, uart2;
+
 // Maximum number of arguments a command may have
 #define MAX_ARGS 8
 
@@ -89,6 +115,26 @@ static inline int isspace(int c)
 	return 0;
 }
 
+static const char * proc_state_str(struct proc *p)
+{
+	switch (p->state) {
+	case PROC_ACTIVE:
+		return "ACTIVE";
+
+	case PROC_RUN:
+		return "RUN";
+
+	case PROC_SLEEP:
+		return "SLEEP";
+
+	case PROC_KILLED:
+		return "KILLED";
+
+	default:
+		return "UNKNOWN";
+	}
+}
+
 static void cmd_ps(int argc, char *argv[])
 {
 	struct proc *p;
@@ -101,31 +147,7 @@ static void cmd_ps(int argc, char *argv[])
 	op = p;
 
 	do {
-		printf("0x%x\t", p->pid);
-
-		switch (p->state) {
-		case PROC_ACTIVE:
-			printf("ACTIVE\t");
-			break;
-
-		case PROC_RUN:
-			printf("RUN\t");
-			break;
-
-		case PROC_SLEEP:
-			printf("SLEEP\t");
-			break;
-
-		case PROC_KILLED:
-			printf("KILLED\t");
-			break;
-
-		default:
-			printf("UNKNOWN\t");
-			break;
-		}
-
-		printf("%s\r\n", p->name);
+		printf("0x%x\t%s\t%s\r\n", p->pid, proc_state_str(p), p->name);
 
 		p = (struct proc *)p->list.next;
 	} while (p != op);
@@ -187,11 +209,11 @@ static void cmd_dumpmem(int argc, char *argv[])
 	x = 0;
 	while (len-- > 0) {
 		if (x == 0)
-			printf("%x| ", addr);
+			printf("%08x| ", addr);
 		else if (x == 4)
 			printf("   ");
 
-		printf("%x ", *(char *)addr);
+		printf("%02x ", *(char *)addr);
 
 		if (++x >= 8) {
 			x = 0;
@@ -227,6 +249,35 @@ static void cmd_alarm(int argc, char *argv[])
 	printf("alarm armed\r\n");
 }
 
+static void cmd_baud(int argc, char *argv[])
+{
+	struct uart *uart = &uart1;
+
+	// An optional port first, "2" for the data channel
+	if (argc == 3) {
+		if (strcmp(argv[1], "2") == 0)
+			uart = &uart2;
+		else if (strcmp(argv[1], "1") != 0)
+			argc = 0;
+		--argc;
+		++argv;
+	}
+
+	if (argc != 2) {
+		printf("baud [1|2] <rate>, currently %d and %d\r\n",
+			uart1.baud, uart2.baud);
+		return;
+	}
+
+	// Queue our stdio output on the UART; set_baud() then drains it at
+	// the old rate before switching
+	if (uart == &uart1)
+		flush();
+
+	if (uart_set_baud(uart, atoi(argv[1])))
+		printf("baud: unable to set %s\r\n", argv[1]);
+}
+
 static void cmd_reset(int argc, char *argv[])
 {
 	reset();
@@ -237,64 +288,281 @@ static void cmd_reset(int argc, char *argv[])
 
 static void cmd_kstat(int argc, char *arg[])
 {
-	struct kstat lkstat;
-	int rc;
+	struct kstat *lkstat;
+	struct kstat_mem_class *mc;
+	struct kstat_slab *sc;
+	struct kstat_uart_fifo *fs;
+	int rc, i;
+
+	// Too big for the stack
+	lkstat = umalloc(sizeof(struct kstat));
+	if (lkstat == NULL) {
+		printf("Unable to allocate kstat buffer\r\n");
+		return;
+	}
 
-	rc = kstat_get(&lkstat);
-	if (rc != 9) {	// @@@ FIXME can not detect correct retval
+	rc = kstat_get(lkstat);
+	if (rc != 0) {
 		printf("kstat_get: %d\r\n", rc);
-	} else {
-		printf("ISR recursions prevented: %d\r\n",lkstat.isr_recursion);
+		goto out;
+	}
+
+	printf("kstat version %d\r\n", lkstat->version);
+	printf("ISR recursions prevented: %d\r\n",lkstat->isr_recursion);
+	printf("Boot: mem_init %d us, first task at %d us\r\n",
+		debug_timer_to_us(lkstat->boot.mem_init),
+		debug_timer_to_us(lkstat->boot.first_task));
+
+	printf("Scheduler\r\n");
+	printf("\tContext switches: %d\r\n", lkstat->sched.switches);
+	printf("\tSystem calls:     %d\r\n", lkstat->sched.syscalls);
+	printf("\tWakeups:          %d\r\n", lkstat->sched.wakeups);
+
+	printf("Memory: %d bytes, %d static, %d failures\r\n",
+		lkstat->mem.heap_size, lkstat->mem.smalloc_used,
+		lkstat->mem.failures);
+	printf("\tSize\tTotal\tIn use\tPeak\tExhausted\r\n");
+	for (i = 0; i < KSTAT_MEM_CLASSES; ++i) {
+		mc = &lkstat->mem.class[i];
+		if (mc->size == 0)
+			continue;
+
+		printf("\t%d\t%d\t%d\t%d\t%d\r\n", mc->size, mc->total,
+			mc->in_use, mc->peak, mc->exhausted);
+	}
+
+	printf("Pool: %d bytes, %d used, %d peak\r\n", lkstat->pool.size,
+		lkstat->pool.used, lkstat->pool.peak);
+
+	printf("Object caches\r\n");
+	printf("\tName\t\tSize\tTotal\tIn use\tPeak\tSlabs\tFailures\r\n");
+	for (i = 0; i < KSTAT_SLABS; ++i) {
+		sc = &lkstat->slab[i];
+		if (sc->name[0] == '\0')
+			continue;
+
+		printf("\t%s\t\t%d\t%d\t%d\t%d\t%d\t%d\r\n", sc->name,
+			sc->size, sc->total, sc->in_use, sc->peak, sc->slabs,
+			sc->failures);
+	}
+
+	printf("Reclaim: %d low-water crossings, %d passes, %d direct, "
+		"%d objects freed\r\n", lkstat->reclaim.pressure,
+		lkstat->reclaim.runs, lkstat->reclaim.direct,
+		lkstat->reclaim.freed);
+
+	for (i = 0; i < KSTAT_UARTS; ++i) {
+		if (lkstat->uart[i].interrupts == 0)
+			continue;
+		fs = &lkstat->uart_fifo[i];
+
+		printf("UART%d\r\n", i + 1);
+		printf("\tBytes received:  %d\r\n", lkstat->uart[i].rx_bytes);
+		printf("\tBytes sent:      %d\r\n", lkstat->uart[i].tx_bytes);
+		printf("\tBytes dropped:   %d\r\n", lkstat->uart[i].rx_dropped);
+		printf("\tInterrupts:      %d\r\n", lkstat->uart[i].interrupts);
+		printf("\tRX interrupts:   %d", fs->rx_interrupts);
+		if (fs->rx_interrupts > 0)
+			printf(" (%d bytes each)",
+				lkstat->uart[i].rx_bytes / fs->rx_interrupts);
+		printf("\r\n\tTX interrupts:   %d", fs->tx_interrupts);
+		if (fs->tx_interrupts > 0)
+			printf(" (%d bytes each)",
+				lkstat->uart[i].tx_bytes / fs->tx_interrupts);
+		printf("\r\n\tOverruns:        %d\r\n", fs->rx_overruns);
 	}
+
+#ifdef CONFIG_NAND
+	printf("NAND\r\n");
+	printf("\tPages read:      %d\r\n", lkstat->nand.pages_read);
+	printf("\tSectors written: %d\r\n", lkstat->nand.sectors_written);
+	printf("\tBlocks erased:   %d\r\n", lkstat->nand.blocks_erased);
+	printf("\tECC corrected:   %d\r\n", lkstat->nand.ecc_corrected);
+	printf("\tECC failed:      %d\r\n", lkstat->nand.ecc_failed);
+#endif
+
+out:
+
+	ufree(lkstat);
+}
+
+#ifdef CONFIG_MEMSTAT
+// @@@ dangerous, no locking
+static struct proc * proc_find(int pid)
+{
+	struct proc *p = cur;
+
+	do {
+		if (p->pid == pid)
+			return p;
+
+		p = (struct proc *)p->list.next;
+	} while (p != cur);
+
+	return NULL;
+}
+
+static void cmd_meminfo_memstat(void)
+{
+	struct memstat_pid *mp;
+	struct memstat_site *ms;
+	struct proc *p;
+	int i;
+
+	printf("Pool requested: %d, untracked: %d\r\n",
+		memstat.pool_requested, memstat.untracked);
+
+	printf("PID\tLive\tPeak\tAllocs\tFails\tState\tName\r\n");
+	for (i = 0; i <= MEMSTAT_PIDS; ++i) {
+		mp = i < MEMSTAT_PIDS ? &memstat.pid[i] : &memstat.other;
+		if (mp->allocs == 0 && mp->failures == 0)
+			continue;
+
+		if (i == MEMSTAT_PIDS) {
+			printf("other\t");
+			p = NULL;
+		} else {
+			printf("0x%x\t", mp->pid);
+			p = proc_find(mp->pid);
+		}
+
+		printf("%d\t%d\t%d\t%d\t%s\t%s\r\n", mp->live, mp->peak,
+			mp->allocs, mp->failures,
+			p != NULL ? proc_state_str(p) : "-",
+			p != NULL ? p->name : "-");
+	}
+
+	printf("Call site\tLive\tCount\tAllocs\tFails\r\n");
+	for (i = 0; i < MEMSTAT_SITES; ++i) {
+		ms = &memstat.site[i];
+		if (ms->pc == 0)
+			continue;
+
+		printf("%x\t%d\t%d\t%d\t%d\r\n", ms->pc, ms->live,
+			ms->count, ms->allocs, ms->failures);
+	}
+
+	if (memstat.sites_dropped > 0)
+		printf("%d allocations from untracked call sites\r\n",
+			memstat.sites_dropped);
+}
+#endif // CONFIG_MEMSTAT
+
+// Per-class usage and, with CONFIG_MEMSTAT, per-task and per-call site
+// usage.  Min free is the low water mark of each class.
+static void cmd_meminfo(int argc, char *argv[])
+{
+	struct kstat *lkstat;
+	struct kstat_mem_class *mc;
+	int i;
+
+	lkstat = umalloc(sizeof(struct kstat));
+	if (lkstat == NULL) {
+		printf("Unable to allocate kstat buffer\r\n");
+		return;
+	}
+
+	kstat_get(lkstat);
+
+	printf("Heap: %d bytes, %d static, %d failures\r\n",
+		lkstat->mem.heap_size, lkstat->mem.smalloc_used,
+		lkstat->mem.failures);
+	printf("Pool: %d bytes, %d used, %d peak\r\n", lkstat->pool.size,
+		lkstat->pool.used, lkstat->pool.peak);
+
+#ifdef CONFIG_MEMSTAT
+	printf("Size\tTotal\tIn use\tMin free\tExhausted\tBytes\tWasted\r\n");
+#else
+	printf("Size\tTotal\tIn use\tMin free\tExhausted\r\n");
+#endif
+	for (i = 0; i < KSTAT_MEM_CLASSES; ++i) {
+		mc = &lkstat->mem.class[i];
+		if (mc->size == 0)
+			continue;
+
+		printf("%d\t%d\t%d\t%d\t\t%d", mc->size, mc->total,
+			mc->in_use, mc->total - mc->peak, mc->exhausted);
+#ifdef CONFIG_MEMSTAT
+		printf("\t\t%d\t%d", mc->in_use * mc->size,
+			mc->in_use * mc->size - memstat.requested[i]);
+#endif
+		printf("\r\n");
+	}
+
+	ufree(lkstat);
+
+#ifdef CONFIG_MEMSTAT
+	cmd_meminfo_memstat();
+#endif
 }
 
 #ifdef CONFIG_NET
 static void cmd_netstat(int argc, char *argv[])
 {
-	struct netstat netstat;
-	int rc;
+	struct netstat *netstat;
+	int rc, i;
 
-	rc = netstat_get(&netstat);
-	if (rc != 10) { // @@@ FIXME can not detect correct retval
+	netstat = umalloc(sizeof(struct netstat));
+	if (netstat == NULL) {
+		printf("Unable to allocate netstat buffer\r\n");
+		return;
+	}
+
+	rc = netstat_get(netstat);
+	if (rc != 0) {
 		printf("netstat_get: %d\r\n", rc);
 	} else {
-		//if (netstat.eth.name[0] != '\0') {
-			puts(netstat.eth.name);
-			printf("\tBytes received:  %d\r\n", netstat.eth.stats.rx_bytes);
-			printf("\tBytes sent:      %d\r\n", netstat.eth.stats.tx_bytes);
-			printf("\tFrames received: %d\r\n", netstat.eth.stats.rx_frames);
-			printf("\tFrames sent:     %d\r\n", netstat.eth.stats.tx_frames);
-			printf("\tRunts:           %d\r\n", netstat.eth.stats.runts);
-			printf("\tOversized:       %d\r\n", netstat.eth.stats.oversized);
-			printf("\tFCS errors:      %d\r\n", netstat.eth.stats.fcs_errors);
-		//}
+		for (i = 0; i < netstat->num_if; ++i) {
+			puts(netstat->eth[i].name);
+			printf("\tBytes received:  %d\r\n", netstat->eth[i].stats.rx_bytes);
+			printf("\tBytes sent:      %d\r\n", netstat->eth[i].stats.tx_bytes);
+			printf("\tFrames received: %d\r\n", netstat->eth[i].stats.rx_frames);
+			printf("\tFrames sent:     %d\r\n", netstat->eth[i].stats.tx_frames);
+			printf("\tRunts:           %d\r\n", netstat->eth[i].stats.runts);
+			printf("\tOversized:       %d\r\n", netstat->eth[i].stats.oversized);
+			printf("\tFCS errors:      %d\r\n", netstat->eth[i].stats.fcs_errors);
+		}
 	}
+
+	ufree(netstat);
 }
 
+// Entries shown by the arp command
+#define ARP_SHOW_MAX	32
+
 static void cmd_arp(int argc, char *argv[])
 {
-	struct list *p;
 	struct en_arp_entry *arp;
+	int i, n;
 
-	printf("MAC\t\t\tIP\r\n");
+	// The cache can change at any time, so work from a copy
+	arp = umalloc(ARP_SHOW_MAX * sizeof(struct en_arp_entry));
+	if (arp == NULL) {
+		printf("Unable to allocate ARP buffer\r\n");
+		return;
+	}
 
-	for (p = arp_cache_list.next; p != NULL; p = p->next) {
-		arp = (struct en_arp_entry *)p;
+	n = en_arp_cache_snapshot(arp, ARP_SHOW_MAX);
 
-		printf("%x:%x:%x:%x:%x:%x\t",
-			arp->hrd_addr.addr[0],
-			arp->hrd_addr.addr[1],
-			arp->hrd_addr.addr[2],
-			arp->hrd_addr.addr[3],
-			arp->hrd_addr.addr[4],
-			arp->hrd_addr.addr[5]);
+	printf("MAC\t\t\tIP\r\n");
+
+	for (i = 0; i < n; ++i) {
+		printf("%02x:%02x:%02x:%02x:%02x:%02x\t",
+			arp[i].hrd_addr.addr[0],
+			arp[i].hrd_addr.addr[1],
+			arp[i].hrd_addr.addr[2],
+			arp[i].hrd_addr.addr[3],
+			arp[i].hrd_addr.addr[4],
+			arp[i].hrd_addr.addr[5]);
 
 		printf("%d.%d.%d.%d\r\n",
-			(arp->proto_addr.addr & 0xFF000000) >> 24,
-			(arp->proto_addr.addr & 0x00FF0000) >> 16,
-			(arp->proto_addr.addr & 0x0000FF00) >> 8,
-			(arp->proto_addr.addr & 0x000000FF));
+			(arp[i].proto_addr.addr & 0xFF000000) >> 24,
+			(arp[i].proto_addr.addr & 0x00FF0000) >> 16,
+			(arp[i].proto_addr.addr & 0x0000FF00) >> 8,
+			(arp[i].proto_addr.addr & 0x000000FF));
 	}
+
+	ufree(arp);
 }
 
 static void cmd_ifconfig(int argc, char *argv[])
@@ -324,7 +592,7 @@ static void cmd_ifconfig(int argc, char *argv[])
 #ifdef CONFIG_NAND
 static void cmd_nand_read_page(int page)
 {
-	char *buf = malloc(NAND_RAW_PAGE_SIZE);
+	char *buf = umalloc(NAND_RAW_PAGE_SIZE);
 	int i;
 	int x = 0;
 	int y = 0;
@@ -339,11 +607,11 @@ static void cmd_nand_read_page(int page)
 
 	for (i = 0, x = 0; i < NAND_RAW_PAGE_SIZE; ++i) {
 		if (x == 0)
-			printf("%x| ", i);
+			printf("%04x| ", i);
 		else if (x == 4)
 			printf("   ");
 
-		printf("%x ", buf[i]);
+		printf("%02x ", buf[i]);
 
 		if (++x >= 8) {
 			x = 0;
@@ -367,12 +635,12 @@ static void cmd_nand_read_page(int page)
 	if (x != 0)
 		puts("");
 
-	free(buf);
+	ufree(buf);
 }
 
 static void cmd_nand_read(int page, int off, int len)
 {
-	char *buf = malloc(len);
+	char *buf = umalloc(len);
 	int i;
 	int x = 0;
 	int y = 0;
@@ -387,11 +655,11 @@ static void cmd_nand_read(int page, int off, int len)
 
 	for (i = 0, x = 0; i < len; ++i) {
 		if (x == 0)
-			printf("%x| ", off + i);
+			printf("%04x| ", off + i);
 		else if (x == 4)
 			printf("   ");
 
-		printf("%x ", buf[i]);
+		printf("%02x ", buf[i]);
 
 		if (++x >= 8) {
 			x = 0;
@@ -415,7 +683,7 @@ static void cmd_nand_read(int page, int off, int len)
 	if (x != 0)
 		puts("");
 
-	free(buf);
+	ufree(buf);
 }
 
 static void cmd_nand_bbscan(void)
@@ -473,7 +741,7 @@ static void cmd_nand_fillsect(int page, int sect, int pattern)
 	char *buf;
 	int status, i;
 
-	buf = malloc(512);
+	buf = umalloc(512);
 	if (buf == NULL) {
 		printf("cmd_nand_fillsect: failed to allocate buffer\r\n");
 		return;
@@ -490,7 +758,7 @@ static void cmd_nand_fillsect(int page, int sect, int pattern)
 
 	printf("Program status: 0x%x\r\n", status);
 
-	free(buf);
+	ufree(buf);
 }
 
 static void cmd_nand(int argc, char *argv[])
@@ -604,7 +872,7 @@ static void cmd_hmm_readpage(int chip, int page)
 
 	char *buf;
 
-	buf = malloc(528);
+	buf = umalloc(528);
 	if (buf == NULL) {
 		printf("Unable to allocate buffer\r\n");
 		goto out;
@@ -623,11 +891,11 @@ static void cmd_hmm_readpage(int chip, int page)
 
 	for (i = 0, x = 0; i < 528; ++i) {
 		if (x == 0)
-			printf("%x| ", i);
+			printf("%04x| ", i);
 		else if (x == 4)
 			printf("   ");
 
-		printf("%x ", buf[i]);
+		printf("%02x ", buf[i]);
 
 		if (++x >= 8) {
 			x = 0;
@@ -651,7 +919,7 @@ static void cmd_hmm_readpage(int chip, int page)
 out:
 
 	if (buf != NULL)
-		free(buf);
+		ufree(buf);
 }
 
 static void cmd_hmm(int argc, char *argv[])
@@ -774,6 +1042,241 @@ out_err:
 }
 #endif // CONFIG_USB
 
+#ifdef CONFIG_BENCH
+static void cmd_bench(int argc, char *argv[])
+{
+	if (argc > 2)
+		goto out_err;
+
+	if (bench_run(argc == 2 ? argv[1] : NULL) == 0)
+		return;
+
+out_err:
+
+	printf("bench [name], available benchmarks:\r\n");
+	bench_list();
+}
+#endif // CONFIG_BENCH
+
+#ifdef CONFIG_IRQSTAT
+static void cmd_irqstat_hist(const char *what, uint32_t *hist)
+{
+	int i;
+
+	printf("\t%s:", what);
+	for (i = 0; i < IRQSTAT_BUCKETS; ++i)
+		printf(" %d", hist[i]);
+	puts("");
+}
+
+static void cmd_irqstat(int argc, char *argv[])
+{
+	struct kstat *ks;
+	struct irqstat_vec *v;
+	int i;
+
+	if (argc == 2 && !strcmp(argv[1], "reset")) {
+		irqstat_reset();
+		return;
+	}
+
+	// Too big for the stack
+	ks = umalloc(sizeof(struct kstat));
+	if (ks == NULL) {
+		printf("Unable to allocate kstat buffer\r\n");
+		return;
+	}
+
+	kstat_get(ks);
+
+	printf("Times in us, histogram bucket n is [2^(n-1), 2^n)\r\n");
+
+	for (i = 0; i < IRQSTAT_VECTORS; ++i) {
+		v = &ks->irq.vec[i];
+		if (v->irq == IRQSTAT_UNUSED)
+			continue;
+
+		printf("IRQ %d: count %d, max time %d, max latency %d\r\n",
+			v->irq, v->count, v->time_max, v->lat_max);
+		cmd_irqstat_hist("time", v->time_hist);
+		if (v->lat_max != 0)
+			cmd_irqstat_hist("latency", v->lat_hist);
+	}
+
+	printf("Longest IRQs off: %d (sti from %x)\r\n",
+		ks->irq.irqoff_max, ks->irq.irqoff_pc);
+	printf("Longest syscall: %d (syscall %d)\r\n",
+		ks->irq.svc_max, ks->irq.svc_num);
+
+	ufree(ks);
+}
+#endif // CONFIG_IRQSTAT
+
+#ifdef CONFIG_PROF
+// Dump the sample histogram, grouped by process.  PCs are printed raw for
+// symbolizing against ertos.map on the host.
+static void cmd_prof_dump(void)
+{
+	struct prof_bucket *b;
+	int pid, next_pid, total;
+	int i;
+
+	printf("Samples: %d, dropped: %d\r\n", prof_samples, prof_dropped);
+
+	pid = -1;
+	while (1) {
+		// Find the next lowest pid with samples
+		next_pid = 0x10000;
+		for (i = 0; i < PROF_BUCKETS; ++i) {
+			b = &prof_buckets[i];
+			if (b->count > 0 && b->pid > pid && b->pid < next_pid)
+				next_pid = b->pid;
+		}
+
+		if (next_pid == 0x10000)
+			break;
+
+		pid = next_pid;
+
+		total = 0;
+		for (i = 0; i < PROF_BUCKETS; ++i) {
+			b = &prof_buckets[i];
+			if (b->count > 0 && b->pid == pid)
+				total += b->count;
+		}
+
+		printf("pid %d: %d samples\r\n", pid, total);
+
+		for (i = 0; i < PROF_BUCKETS; ++i) {
+			b = &prof_buckets[i];
+			if (b->count > 0 && b->pid == pid)
+				printf("\t%x\t%d\r\n",
+					b->pc << PROF_PC_SHIFT, b->count);
+		}
+	}
+}
+
+static void cmd_prof(int argc, char *argv[])
+{
+	if (argc < 2)
+		goto out_err;
+
+	if (!strcmp(argv[1], "start")) {
+		prof_start(argc > 2 ? atoi(argv[2]) : 1);
+	} else if (!strcmp(argv[1], "stop")) {
+		prof_stop();
+	} else if (!strcmp(argv[1], "reset")) {
+		prof_reset();
+	} else if (!strcmp(argv[1], "dump")) {
+		cmd_prof_dump();
+	} else {
+		goto out_err;
+	}
+
+	return;
+
+out_err:
+
+	printf("supported commands:\r\n");
+	printf("\tdump\r\n");
+	printf("\treset\r\n");
+	printf("\tstart [ticks between samples]\r\n");
+	printf("\tstop\r\n");
+}
+#endif // CONFIG_PROF
+
+#ifdef CONFIG_TRACE
+static const char *trace_type_str[] = {
+	"none",
+	"switch",
+	"irq-entry",
+	"irq-exit",
+	"syscall-entry",
+	"syscall-exit",
+	"wakeup",
+};
+
+static void cmd_trace_hex(const uint8_t *p, int len)
+{
+	static const char hex[] = "0123456789abcdef";
+
+	while (len-- > 0) {
+		putchar(hex[*p >> 4]);
+		putchar(hex[*p & 0xf]);
+		++p;
+	}
+}
+
+// Dump the trace ring.  With export set the records are written out as hex
+// encoded raw records, one per line, framed by begin/end markers so a host
+// tool can pick them out of the console log.
+static void cmd_trace_dump(int export)
+{
+	struct trace_rec recs[16];
+	uint32_t pos = 0;
+	int i, n;
+
+	if (export)
+		printf("trace-begin %d %d %d\r\n", TRACE_VERSION,
+			DEBUG_TIMER_HZ, sizeof(struct trace_rec));
+	else
+		printf("Timestamp\tPID\tEvent\t\tArg\r\n");
+
+	while ((n = trace_read(recs, 16, &pos)) > 0) {
+		for (i = 0; i < n; ++i) {
+			if (export) {
+				cmd_trace_hex((uint8_t *)&recs[i],
+					sizeof(struct trace_rec));
+				puts("");
+				continue;
+			}
+
+			printf("%d\t%d\t%s\t", recs[i].ts, recs[i].pid,
+				recs[i].type <= TRACE_WAKEUP
+				? trace_type_str[recs[i].type] : "?");
+			if (recs[i].type != TRACE_SYSCALL_ENTRY
+				&& recs[i].type != TRACE_SYSCALL_EXIT)
+				putchar('\t');
+			printf("%d\r\n", recs[i].arg);
+		}
+	}
+
+	if (export)
+		puts("trace-end");
+}
+
+static void cmd_trace(int argc, char *argv[])
+{
+	if (argc < 2)
+		goto out_err;
+
+	if (!strcmp(argv[1], "start")) {
+		trace_start();
+	} else if (!strcmp(argv[1], "stop")) {
+		trace_stop();
+	} else if (!strcmp(argv[1], "clear")) {
+		trace_clear();
+	} else if (!strcmp(argv[1], "dump")) {
+		cmd_trace_dump(0);
+	} else if (!strcmp(argv[1], "export")) {
+		cmd_trace_dump(1);
+	} else {
+		goto out_err;
+	}
+
+	return;
+
+out_err:
+
+	printf("supported commands:\r\n");
+	printf("\tclear\r\n");
+	printf("\tdump\r\n");
+	printf("\texport\r\n");
+	printf("\tstart\r\n");
+	printf("\tstop\r\n");
+}
+#endif // CONFIG_TRACE
+
 struct command {
 	const char *name;
 	void (*func)(int, char **);
@@ -787,6 +1290,10 @@ struct command commands[] = {
 	{ "alarm", cmd_alarm, "test alarm: alarm <msec> <oneshot>" },
 #ifdef CONFIG_NET
 	{ "arp", cmd_arp, "display ARP cache" },
+#endif
+	{ "baud", cmd_baud, "set the console BAUD rate: baud <rate>" },
+#ifdef CONFIG_BENCH
+	{ "bench", cmd_bench, "run benchmarks: bench [name]" },
 #endif
 	{ "dumpmem",cmd_dumpmem, "dump memory location: dumpmem <addr> <len>" },
 	{ "exit", cmd_exit, "exit the console" },
@@ -796,19 +1303,29 @@ struct command commands[] = {
 #endif
 #ifdef CONFIG_NET
 	{ "ifconfig", cmd_ifconfig, "configure Ethernet interfaces" },
+#endif
+#ifdef CONFIG_IRQSTAT
+	{ "irqstat", cmd_irqstat, "interrupt statistics: irqstat [reset]" },
 #endif
 	{ "kstat", cmd_kstat, "dump kernel statistics" },
+	{ "meminfo", cmd_meminfo, "memory usage by class, task and call site" },
 #ifdef CONFIG_NAND
 	{ "nand", cmd_nand, "NAND flash operations" },
 #endif
 #ifdef CONFIG_NET
 	{ "netstat", cmd_netstat, "dump network statistics" },
+#endif
+#ifdef CONFIG_PROF
+	{ "prof", cmd_prof, "sampling profiler" },
 #endif
 	{ "ps", cmd_ps, "list running processes" },
 	{ "reset", cmd_reset, "reset the system" },
 #ifdef CONFIG_SPI
 	{ "spi", cmd_spi, "SPI commands" },
 #endif
+#ifdef CONFIG_TRACE
+	{ "trace", cmd_trace, "kernel event tracing" },
+#endif
 #ifdef CONFIG_USB
 	{ "usb", cmd_usb, "USB commands" },
 #endif